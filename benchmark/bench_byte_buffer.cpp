@@ -0,0 +1,77 @@
+#include "benchmark.h"
+
+#include "engine/network/auth_packets.h"
+#include "engine/network/auth_session.h"
+#include "engine/utils/byte_buffer.h"
+
+namespace {
+
+  auto make_challenge_request() -> loki::PaketAuthChallengeRequest
+  {
+    loki::PaketAuthChallengeRequest pkt;
+    pkt.protocol_version = 8;
+    pkt.packet_size = 34;
+    pkt.build = 12'340;
+    pkt.login = { 'T', 'E', 'S', 'T' };
+    return pkt;
+  }
+
+  auto make_challenge_response() -> loki::PaketAuthChallengeResponse
+  {
+    loki::PaketAuthChallengeResponse pkt;
+    pkt.g = { 7 };
+    pkt.N.resize(32, 0xAB);
+    return pkt;
+  }
+
+  auto make_realm() -> loki::PacketAuthRealm
+  {
+    loki::PacketAuthRealm realm;
+    realm.name = "Loki Test Realm";
+    realm.server_socket = "127.0.0.1:8085";
+    realm.realm_id = 1;
+    return realm;
+  }
+
+  template<typename Packet>
+  void save_packet(loki::bench::State& state, Packet pkt)
+  {
+    loki::ByteBuffer buffer;
+
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      buffer.reset();
+      buffer.save_buffer(pkt);
+      loki::bench::clobber_memory();
+      ++items;
+    }
+    state.set_items_processed(items);
+  }
+
+  template<typename Packet>
+  void load_packet(loki::bench::State& state, Packet pkt)
+  {
+    loki::ByteBuffer buffer;
+    buffer.save_buffer(pkt);
+
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      Packet loaded;
+      buffer.set_r_pos(0);
+      buffer.load_buffer(loaded);
+      loki::bench::do_not_optimize(loaded);
+      ++items;
+    }
+    state.set_items_processed(items);
+  }
+
+} // namespace
+
+LOKI_BENCHMARK("byte_buffer/save/challenge_request", [](auto& state) { save_packet(state, make_challenge_request()); });
+LOKI_BENCHMARK("byte_buffer/load/challenge_request", [](auto& state) { load_packet(state, make_challenge_request()); });
+LOKI_BENCHMARK("byte_buffer/save/challenge_response", [](auto& state) { save_packet(state, make_challenge_response()); });
+LOKI_BENCHMARK("byte_buffer/load/challenge_response", [](auto& state) { load_packet(state, make_challenge_response()); });
+LOKI_BENCHMARK("byte_buffer/save/logon_proof_request", [](auto& state) { save_packet(state, loki::PaketAuthLogonProofRequest{}); });
+LOKI_BENCHMARK("byte_buffer/load/logon_proof_response", [](auto& state) { load_packet(state, loki::PaketAuthLogonProofResponse{}); });
+LOKI_BENCHMARK("byte_buffer/save/realm", [](auto& state) { save_packet(state, make_realm()); });
+LOKI_BENCHMARK("byte_buffer/load/realm", [](auto& state) { load_packet(state, make_realm()); });
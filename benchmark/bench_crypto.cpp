@@ -0,0 +1,145 @@
+#include "benchmark.h"
+
+#include "engine/crypto/arc_4.h"
+#include "engine/crypto/crypto_hash.h"
+#include "engine/crypto/crypto_hmac.h"
+#include "engine/crypto/crypto_random.h"
+#include "engine/crypto/srp_6.h"
+#include "engine/utils/big_num.h"
+
+#include <vector>
+
+namespace {
+
+  // The SRP6 safe prime and generator used by 3.3.5 auth servers
+  constexpr const char srp6_N[] = "894B645E89E1535BBDAD5B8B290650530801B18EBFBF5E8FAB3C82872A3E9BB7";
+  constexpr loki::u32 srp6_g = 7;
+
+  auto make_N() -> loki::BigNum
+  {
+    loki::BigNum N;
+    N.set_hex_str(srp6_N);
+    return N;
+  }
+
+  auto make_g() -> loki::BigNum
+  {
+    loki::BigNum g;
+    g.set_dword(srp6_g);
+    return g;
+  }
+
+  void arc4_update_data(loki::bench::State& state)
+  {
+    std::vector<loki::u8> data(state.get_arg(), 0x5A);
+
+    loki::ARC4 arc4;
+    arc4.init(loki::crypto::get_random_bytes<40>());
+
+    loki::u64 bytes = 0;
+    while (state.keep_running()) {
+      arc4.update_data(data);
+      loki::bench::clobber_memory();
+      bytes += data.size();
+    }
+    state.set_bytes_processed(bytes);
+  }
+
+  void sha1_digest(loki::bench::State& state)
+  {
+    std::vector<loki::u8> data(state.get_arg(), 0x5A);
+
+    loki::u64 bytes = 0;
+    while (state.keep_running()) {
+      auto digest = loki::crypto::SHA1::get_digest_of(data);
+      loki::bench::do_not_optimize(digest);
+      bytes += data.size();
+    }
+    state.set_bytes_processed(bytes);
+  }
+
+  void hmac_sha1_digest(loki::bench::State& state)
+  {
+    std::vector<loki::u8> data(state.get_arg(), 0x5A);
+    auto key = loki::crypto::get_random_bytes<16>();
+
+    loki::u64 bytes = 0;
+    while (state.keep_running()) {
+      auto digest = loki::crypto::HMAC_SHA1::get_digest_of(key, data);
+      loki::bench::do_not_optimize(digest);
+      bytes += data.size();
+    }
+    state.set_bytes_processed(bytes);
+  }
+
+  void random_bytes(loki::bench::State& state)
+  {
+    std::vector<loki::u8> data(state.get_arg());
+
+    loki::u64 bytes = 0;
+    while (state.keep_running()) {
+      loki::crypto::get_random_bytes(data);
+      loki::bench::clobber_memory();
+      bytes += data.size();
+    }
+    state.set_bytes_processed(bytes);
+  }
+
+  void big_num_mul(loki::bench::State& state)
+  {
+    auto a = loki::BigNum::from_random(256);
+    auto b = loki::BigNum::from_random(256);
+
+    while (state.keep_running()) {
+      auto c = a * b;
+      loki::bench::do_not_optimize(c);
+    }
+  }
+
+  void big_num_add(loki::bench::State& state)
+  {
+    auto a = loki::BigNum::from_random(256);
+    auto b = loki::BigNum::from_random(256);
+
+    while (state.keep_running()) {
+      auto c = a + b;
+      loki::bench::do_not_optimize(c);
+    }
+  }
+
+  void big_num_mod_exp(loki::bench::State& state)
+  {
+    auto N = make_N();
+    auto g = make_g();
+    auto x = loki::BigNum::from_random(160);
+
+    while (state.keep_running()) {
+      auto v = g.mod_exp(x, N);
+      loki::bench::do_not_optimize(v);
+    }
+  }
+
+  void srp6_generate(loki::bench::State& state)
+  {
+    auto N = make_N();
+    auto g = make_g();
+    auto B = g.mod_exp(loki::BigNum::from_random(152), N).to_byte_array<loki::SRP6::EPHEMERAL_KEY_LENGTH>();
+    auto salt = loki::crypto::get_random_bytes<loki::SRP6::SALT_LENGTH>();
+
+    while (state.keep_running()) {
+      loki::SRP6 srp6{ N, g };
+      srp6.generate(salt, B, "TEST", "TEST");
+      loki::bench::do_not_optimize(srp6.get_session_key());
+    }
+  }
+
+} // namespace
+
+LOKI_BENCHMARK("arc4/update_data", arc4_update_data, 4, 64, 1'024, 16'384);
+LOKI_BENCHMARK("sha1/get_digest_of", sha1_digest, 20, 64, 1'024, 16'384);
+LOKI_BENCHMARK("hmac_sha1/get_digest_of", hmac_sha1_digest, 20, 64, 1'024, 16'384);
+LOKI_BENCHMARK("crypto/get_random_bytes", random_bytes, 4, 32, 1'024);
+LOKI_BENCHMARK("big_num/add", big_num_add);
+LOKI_BENCHMARK("big_num/mul", big_num_mul);
+LOKI_BENCHMARK("big_num/mod_exp", big_num_mod_exp);
+LOKI_BENCHMARK("srp6/generate", srp6_generate);
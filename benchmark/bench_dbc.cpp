@@ -0,0 +1,208 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "engine/datasource/dbc/dbc_hot_columns.h"
+#include "engine/datasource/dbc/dbc_schemas.h"
+#include "engine/datasource/dbc/dbc_table.h"
+
+namespace {
+
+  // About as many records as the 3.3.5a Spell.dbc
+  constexpr loki::u32 SPELL_COUNT = 49'839;
+  // Rows of the synthetic SpellCastTimes.dbc and SpellDuration.dbc, ids 1 to this
+  constexpr loki::u32 TIMING_COUNT = 200;
+
+  // A DBC file without strings, make_record(row) gives each record
+  template<loki::IsDBCRecord T, typename F>
+  auto make_dbc(loki::u32 count, const F& make_record) -> std::vector<std::byte>
+  {
+    loki::DBCHeader header{ loki::DBCFile::MAGIC, count, T::FIELD_COUNT, sizeof(T), 1 };
+    std::vector<std::byte> data(sizeof(header) + count * sizeof(T) + header.string_block_size);
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    for (loki::u32 row = 0; row < count; ++row) {
+      T record = make_record(row);
+      std::memcpy(data.data() + sizeof(header) + row * sizeof(T), &record, sizeof(T));
+    }
+
+    return data;
+  }
+
+  // A Spell.dbc whose ids are spread over spread times as many values as it has records
+  auto make_spell_dbc(loki::u32 spread) -> std::vector<std::byte>
+  {
+    std::mt19937 random{ spread };
+    std::uniform_int_distribution<loki::u32> gap{ 1, 2 * spread - 1 };
+    std::uniform_int_distribution<loki::u32> index{ 0, TIMING_COUNT };
+
+    loki::u32 id = 0;
+    return make_dbc<loki::SpellRecord>(SPELL_COUNT, [&](loki::u32) {
+      loki::SpellRecord record{};
+      id += gap(random);
+      record.id = id;
+      record.casting_time_index = index(random);
+      record.duration_index = index(random);
+      return record;
+    });
+  }
+
+  // Stays around for the views the tables keep
+  struct SpellTable
+  {
+    std::vector<std::byte> data;
+    loki::DBCTable<loki::SpellRecord> table;
+    std::vector<loki::u32> ids;
+  };
+
+  auto make_spell_table(loki::u32 spread) -> SpellTable
+  {
+    SpellTable result;
+    result.data = make_spell_dbc(spread);
+    result.table = loki::DBCTable<loki::SpellRecord>{ loki::MPQFileData{ result.data } };
+    for (const loki::SpellRecord& record : result.table) {
+      result.ids.push_back(record.id);
+    }
+
+    // Looked up in an order the records aren't in, like spell ids coming off the network
+    std::shuffle(result.ids.begin(), result.ids.end(), std::mt19937{ 0 });
+    return result;
+  }
+
+  // Ids up to about twice the record count, like the real Spell.dbc, and ten times that
+  auto get_dense_spells() -> const SpellTable&
+  {
+    static const SpellTable table = make_spell_table(2);
+    return table;
+  }
+
+  auto get_sparse_spells() -> const SpellTable&
+  {
+    static const SpellTable table = make_spell_table(20);
+    return table;
+  }
+
+  // Up to 20 seconds to cast, up to 200 seconds long, every tenth duration doesn't run out
+  struct SpellTimingTables
+  {
+    std::vector<std::byte> cast_times_data;
+    std::vector<std::byte> durations_data;
+    loki::DBCTable<loki::SpellCastTimesRecord> cast_times;
+    loki::DBCTable<loki::SpellDurationRecord> durations;
+  };
+
+  auto get_spell_timing_tables() -> const SpellTimingTables&
+  {
+    static const SpellTimingTables tables = []() {
+      SpellTimingTables result;
+      result.cast_times_data = make_dbc<loki::SpellCastTimesRecord>(TIMING_COUNT, [](loki::u32 row) {
+        return loki::SpellCastTimesRecord{ row + 1, static_cast<loki::i32>(row * 100), 0, 0 };
+      });
+      result.durations_data = make_dbc<loki::SpellDurationRecord>(TIMING_COUNT, [](loki::u32 row) {
+        loki::i32 base = row % 10 == 0 ? loki::SpellTimingColumns::UNLIMITED : static_cast<loki::i32>(row * 1000);
+        return loki::SpellDurationRecord{ row + 1, base, 0, base };
+      });
+      result.cast_times = loki::DBCTable<loki::SpellCastTimesRecord>{ loki::MPQFileData{ result.cast_times_data } };
+      result.durations = loki::DBCTable<loki::SpellDurationRecord>{ loki::MPQFileData{ result.durations_data } };
+      return result;
+    }();
+    return tables;
+  }
+
+  // The query both scans run: spells with a cast time of 1.5s or more that last longer than 10s
+  auto is_long_spell(loki::i32 cast_time_ms, loki::i32 duration_ms) -> bool
+  {
+    return cast_time_ms >= 1500 && (duration_ms == loki::SpellTimingColumns::UNLIMITED || duration_ms > 10'000);
+  }
+
+  template<auto GetTable>
+  void dbc_find(loki::bench::State& state)
+  {
+    const SpellTable& spells = GetTable();
+    if (spells.table.get_index().is_dense() != (GetTable == &get_dense_spells)) {
+      state.skip("The index isn't the kind this benchmark is for");
+      return;
+    }
+
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      const loki::SpellRecord* record = spells.table.find(spells.ids[items % spells.ids.size()]);
+      loki::bench::do_not_optimize(record);
+      ++items;
+    }
+    state.set_items_processed(items);
+  }
+
+  // What the index is measured against
+  void dbc_find_unordered_map(loki::bench::State& state)
+  {
+    const SpellTable& spells = get_sparse_spells();
+    static const auto rows = [&spells]() {
+      std::unordered_map<loki::u32, const loki::SpellRecord*> result;
+      for (const loki::SpellRecord& record : spells.table) {
+        result.emplace(record.id, &record);
+      }
+      return result;
+    }();
+
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      auto it = rows.find(spells.ids[items % spells.ids.size()]);
+      loki::bench::do_not_optimize(it);
+      ++items;
+    }
+    state.set_items_processed(items);
+  }
+
+  // Every record, with both of its timings looked up in their tables
+  void dbc_scan_records(loki::bench::State& state)
+  {
+    const SpellTable& spells = get_dense_spells();
+    const SpellTimingTables& timings = get_spell_timing_tables();
+
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      loki::u32 count = 0;
+      for (const loki::SpellRecord& record : spells.table) {
+        const loki::SpellCastTimesRecord* cast_time = timings.cast_times.find(record.casting_time_index);
+        const loki::SpellDurationRecord* duration = timings.durations.find(record.duration_index);
+        count += is_long_spell(cast_time ? cast_time->base : loki::SpellTimingColumns::NONE,
+                               duration ? duration->base : loki::SpellTimingColumns::NONE);
+      }
+      loki::bench::do_not_optimize(count);
+      items += spells.table.size();
+    }
+    state.set_items_processed(items);
+  }
+
+  void dbc_scan_hot_columns(loki::bench::State& state)
+  {
+    const SpellTable& spells = get_dense_spells();
+    const SpellTimingTables& timings = get_spell_timing_tables();
+    static const loki::SpellTimingColumns columns{ spells.table, timings.cast_times, timings.durations };
+    auto cast_times = columns.get_cast_times_ms();
+    auto durations = columns.get_durations_ms();
+
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      loki::u32 count = 0;
+      for (size_t row = 0; row < columns.size(); ++row) {
+        count += is_long_spell(cast_times[row], durations[row]);
+      }
+      loki::bench::do_not_optimize(count);
+      items += columns.size();
+    }
+    state.set_items_processed(items);
+  }
+
+} // namespace
+
+LOKI_BENCHMARK("dbc/find/dense", dbc_find<&get_dense_spells>);
+LOKI_BENCHMARK("dbc/find/perfect_hash", dbc_find<&get_sparse_spells>);
+LOKI_BENCHMARK("dbc/find/unordered_map", dbc_find_unordered_map);
+LOKI_BENCHMARK("dbc/scan/records", dbc_scan_records);
+LOKI_BENCHMARK("dbc/scan/hot_columns", dbc_scan_hot_columns);
@@ -0,0 +1,144 @@
+#include "benchmark.h"
+
+#include "engine/jobs/job_system.h"
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  constexpr loki::u32 ITEM_COUNT = 0x10000;
+  constexpr loki::u32 BATCH_SIZE = 256;
+  constexpr loki::u32 EMPTY_JOBS = 1'024;
+  constexpr loki::u32 FAN_OUT = 64;
+  constexpr loki::u32 FAN_OUT_ITEMS = ITEM_COUNT / FAN_OUT;
+
+  // 1, 2, 4, ... up to every hardware thread, so the results read as a scaling curve
+  auto get_worker_counts() -> std::vector<loki::i64>
+  {
+    loki::i64 hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::vector<loki::i64> counts;
+    for (loki::i64 count = 1; count < hardware_threads; count *= 2) {
+      counts.push_back(count);
+    }
+
+    counts.push_back(hardware_threads);
+    return counts;
+  }
+
+  // Restarts the job system whenever a benchmark wants a different number of workers
+  void use_workers(loki::i64 count)
+  {
+    static struct Shutdown
+    {
+      ~Shutdown()
+      {
+        loki::JobSystem::term();
+      }
+    } shutdown;
+
+    if (loki::JobSystem::get_worker_count() != static_cast<loki::u32>(count)) {
+      loki::JobSystem::term();
+      loki::JobSystem::init({ static_cast<loki::u32>(count), false });
+    }
+  }
+
+  // Roughly what culling or skinning a batch costs, a few hundred cycles per item
+  auto simulate_item(loki::u32 item) -> float
+  {
+    float value = static_cast<float>(item);
+    for (int i = 0; i < 32; ++i) {
+      value = std::sqrt(value * 1.0001f + 1.f);
+    }
+
+    return value;
+  }
+
+  void jobs_parallel_for(loki::bench::State& state)
+  {
+    use_workers(state.get_arg());
+    std::vector<float> results(ITEM_COUNT);
+
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      loki::JobCounter counter;
+      loki::JobSystem::parallel_for(
+          ITEM_COUNT, BATCH_SIZE,
+          [&results](loki::u32 begin, loki::u32 end) {
+            for (loki::u32 i = begin; i < end; ++i) {
+              results[i] = simulate_item(i);
+            }
+          },
+          counter);
+      loki::JobSystem::wait(counter);
+
+      loki::bench::do_not_optimize(results.data());
+      items += ITEM_COUNT;
+    }
+    state.set_items_processed(items);
+  }
+
+  void jobs_empty(loki::bench::State& state)
+  {
+    // Scheduling overhead alone: submit, steal, run nothing, count down
+    use_workers(state.get_arg());
+
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      loki::JobCounter counter;
+      for (loki::u32 i = 0; i < EMPTY_JOBS; ++i) {
+        loki::JobSystem::run([]() {}, &counter);
+      }
+      loki::JobSystem::wait(counter);
+      items += EMPTY_JOBS;
+    }
+    state.set_items_processed(items);
+  }
+
+  void jobs_fan_out_fan_in(loki::bench::State& state)
+  {
+    // A frame's worth of dependent work: batches, then one job that reduces them once they're all done
+    use_workers(state.get_arg());
+    std::vector<float> partials(FAN_OUT);
+
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      loki::JobCounter batches;
+      loki::JobCounter reduce;
+      float total = 0.f;
+
+      for (loki::u32 i = 0; i < FAN_OUT; ++i) {
+        loki::JobSystem::run(
+            [&partials, i]() {
+              float sum = 0.f;
+              for (loki::u32 item = i * FAN_OUT_ITEMS; item < (i + 1) * FAN_OUT_ITEMS; ++item) {
+                sum += simulate_item(item);
+              }
+              partials[i] = sum;
+            },
+            &batches);
+      }
+
+      loki::JobSystem::run_after(
+          batches,
+          [&partials, &total]() {
+            for (float partial : partials) {
+              total += partial;
+            }
+          },
+          &reduce);
+      loki::JobSystem::wait(reduce);
+
+      loki::bench::do_not_optimize(total);
+      items += ITEM_COUNT;
+    }
+    state.set_items_processed(items);
+  }
+
+  const bool registered = loki::bench::register_benchmark("jobs/parallel_for", jobs_parallel_for, get_worker_counts())
+                       && loki::bench::register_benchmark("jobs/empty", jobs_empty, get_worker_counts())
+                       && loki::bench::register_benchmark("jobs/fan_out_fan_in", jobs_fan_out_fan_in, get_worker_counts());
+
+} // namespace
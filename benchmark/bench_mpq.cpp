@@ -0,0 +1,359 @@
+#include "benchmark.h"
+
+#include "engine/datasource/mpq/mpq_chain.h"
+#include "engine/datasource/mpq/mpq_file_cache.h"
+#include "engine/datasource/pack/asset_pack.h"
+#include "engine/jobs/job_system.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+  // The biggest files of each kind, big enough that opening them isn't what's measured
+  constexpr size_t FILE_COUNT = 16;
+  // Every page of what was read is touched once, a mapped file is only read from disk then
+  constexpr size_t PAGE_SIZE = 0x1000;
+  constexpr size_t CACHE_SIZE = 0x4000'0000;
+
+  auto get_index_path() -> std::filesystem::path
+  {
+    return std::filesystem::temp_directory_path() / "loki_bench_mpq_index.bin";
+  }
+
+  enum class FileKind : loki::u8
+  {
+    ADT = 0,
+    BLP = 1,
+    // Any type, stored uncompressed, so the mapped path is what runs
+    STORED = 2,
+  };
+
+  struct SampleFile
+  {
+    std::string name;
+    loki::u64 size;
+    // The archive the chain reads it from
+    HANDLE archive;
+  };
+
+  struct Samples
+  {
+    std::unique_ptr<loki::MPQChain> chain;
+    // Big enough for every sample, after the first run it's hits only
+    std::unique_ptr<loki::MPQFileCache> cache;
+    std::array<std::vector<SampleFile>, 3> files;
+  };
+
+  auto ends_with(std::string_view name, std::string_view extension) -> bool
+  {
+    return name.size() >= extension.size()
+        && std::equal(extension.rbegin(), extension.rend(), name.rbegin(), [](char a, char b) {
+             return a == std::tolower(static_cast<unsigned char>(b));
+           });
+  }
+
+  // The chain opens its archives on the job system, every hardware thread unless the jobs benchmarks
+  // picked another count already
+  void use_job_system()
+  {
+    static struct Shutdown
+    {
+      ~Shutdown()
+      {
+        loki::JobSystem::term();
+      }
+    } shutdown;
+
+    if (!loki::JobSystem::is_initialized()) {
+      loki::JobSystem::init({});
+    }
+  }
+
+  // Loaded on first use, the chain and its file list are the slow part
+  auto get_samples() -> Samples&
+  {
+    static Samples samples = []() {
+      Samples result;
+      const auto& data_path = loki::bench::get_settings().data_path;
+      if (data_path.empty()) {
+        return result;
+      }
+
+      use_job_system();
+      result.chain = std::make_unique<loki::MPQChain>(data_path, get_index_path());
+      result.chain->wait_until_loaded();
+      result.cache = std::make_unique<loki::MPQFileCache>(*result.chain, CACHE_SIZE);
+
+      // Newest archive first, a name seen before is a file a patch replaced
+      std::set<std::string> seen;
+      for (size_t i = 0; i < result.chain->get_archive_count(); ++i) {
+        HANDLE archive = result.chain->get_archive(i)->get_handle();
+        SFILE_FIND_DATA data{};
+        HANDLE find = archive ? SFileFindFirstFile(archive, "*", &data, nullptr) : nullptr;
+        for (bool found = find != nullptr; found; found = SFileFindNextFile(find, &data)) {
+          if (!seen.insert(data.cFileName).second) {
+            continue;
+          }
+
+          SampleFile file{ data.cFileName, data.dwFileSize, archive };
+          if (ends_with(file.name, ".adt")) {
+            result.files[static_cast<size_t>(FileKind::ADT)].push_back(file);
+          } else if (ends_with(file.name, ".blp")) {
+            result.files[static_cast<size_t>(FileKind::BLP)].push_back(file);
+          }
+
+          if ((data.dwFileFlags & MPQ_FILE_COMPRESS_MASK) == 0) {
+            result.files[static_cast<size_t>(FileKind::STORED)].push_back(file);
+          }
+        }
+
+        if (find) {
+          SFileFindClose(find);
+        }
+      }
+
+      for (auto& files : result.files) {
+        auto middle = files.begin() + static_cast<std::ptrdiff_t>(std::min(files.size(), FILE_COUNT));
+        std::partial_sort(files.begin(), middle, files.end(), [](const auto& a, const auto& b) {
+          return a.size > b.size;
+        });
+        files.erase(middle, files.end());
+      }
+
+      return result;
+    }();
+
+    return samples;
+  }
+
+  auto get_files(loki::bench::State& state, FileKind kind) -> const std::vector<SampleFile>*
+  {
+    auto& samples = get_samples();
+    if (!samples.chain) {
+      state.skip("no --data directory");
+      return nullptr;
+    }
+
+    const auto& files = samples.files[static_cast<size_t>(kind)];
+    if (files.empty()) {
+      state.skip("no such files in the data directory");
+      return nullptr;
+    }
+
+    return &files;
+  }
+
+  auto touch_pages(std::span<const std::byte> data) -> loki::u8
+  {
+    loki::u8 sum = 0;
+    for (size_t i = 0; i < data.size(); i += PAGE_SIZE) {
+      sum += static_cast<loki::u8>(data[i]);
+    }
+
+    return sum;
+  }
+
+  // The way it was done before MPQFile: open, a fresh buffer, SFileReadFile, close
+  void sfile_read_file(loki::bench::State& state, FileKind kind)
+  {
+    const auto* files = get_files(state, kind);
+
+    loki::u64 bytes = 0;
+    while (state.keep_running()) {
+      for (const auto& sample : *files) {
+        HANDLE file{};
+        if (!SFileOpenFileEx(sample.archive, sample.name.c_str(), SFILE_OPEN_FROM_MPQ, &file)) {
+          continue;
+        }
+
+        std::vector<std::byte> buffer(sample.size);
+        DWORD read = 0;
+        SFileReadFile(file, buffer.data(), static_cast<DWORD>(sample.size), &read, nullptr);
+        SFileCloseFile(file);
+
+        loki::bench::do_not_optimize(touch_pages(buffer));
+        bytes += read;
+      }
+    }
+    state.set_bytes_processed(bytes);
+  }
+
+  void mpq_file_read_all(loki::bench::State& state, FileKind kind)
+  {
+    const auto* files = get_files(state, kind);
+
+    loki::u64 bytes = 0;
+    while (state.keep_running()) {
+      for (const auto& sample : *files) {
+        loki::MPQFile file = get_samples().chain->open_file(sample.name);
+        loki::MPQFileData data = file.read_all();
+
+        loki::bench::do_not_optimize(touch_pages(data.get_span()));
+        bytes += data.get_span().size();
+      }
+    }
+    state.set_bytes_processed(bytes);
+  }
+
+  // Startup until every archive is open, warm only: their pages are cached after the first iteration, and
+  // so is the file index. The chain logs when it was ready for the game to start, before the speech
+  // archives were in. For a cold start drop the page cache and run it with --repetitions 1 --min-time 0.
+  void open_chain(loki::bench::State& state)
+  {
+    const auto& data_path = loki::bench::get_settings().data_path;
+    if (data_path.empty()) {
+      state.skip("no --data directory");
+      return;
+    }
+
+    use_job_system();
+    while (state.keep_running()) {
+      loki::MPQChain chain{ data_path, get_index_path() };
+      chain.wait_until_loaded();
+      loki::bench::do_not_optimize(chain.get_archive_count());
+    }
+  }
+
+  // A probe of the index per name
+  void has_file(loki::bench::State& state)
+  {
+    const auto* files = get_files(state, FileKind::BLP);
+
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      for (const auto& sample : *files) {
+        loki::bench::do_not_optimize(get_samples().chain->has_file(sample.name));
+      }
+      items += files->size();
+    }
+    state.set_items_processed(items);
+  }
+
+  // Every thread reads all the samples, each starting at another one
+  template<typename Read>
+  void read_concurrently(loki::bench::State& state, Read&& read)
+  {
+    const auto* files = get_files(state, FileKind::BLP);
+
+    loki::u64 bytes = 0;
+    while (state.keep_running()) {
+      for (size_t i = 0; i < files->size(); ++i) {
+        const auto& sample = (*files)[(i + static_cast<size_t>(state.get_thread_index())) % files->size()];
+        loki::MPQFileData data = read(sample.name);
+
+        loki::bench::do_not_optimize(touch_pages(data.get_span()));
+        bytes += data.get_span().size();
+      }
+    }
+    state.set_bytes_processed(bytes);
+  }
+
+  // The chain's own handles, one thread at a time
+  void concurrent_read_locked(loki::bench::State& state)
+  {
+    static std::mutex mutex;
+    read_concurrently(state, [](const std::string& name) {
+      std::scoped_lock lock{ mutex };
+      return get_samples().chain->open_file(name).read_all();
+    });
+  }
+
+  // Handles of each thread's own. The benchmark's threads are new every run, but the ids of joined threads
+  // usually come back, so archives are opened again in the first runs only.
+  void concurrent_read_pooled(loki::bench::State& state)
+  {
+    read_concurrently(state, [](const std::string& name) {
+      return get_samples().chain->get_readers().open_file(name).read_all();
+    });
+  }
+
+  // Hits, the cost of a lookup and a pin next to the reads above
+  void concurrent_read_cached(loki::bench::State& state)
+  {
+    const auto* files = get_files(state, FileKind::BLP);
+
+    loki::u64 bytes = 0;
+    while (state.keep_running()) {
+      for (size_t i = 0; i < files->size(); ++i) {
+        const auto& sample = (*files)[(i + static_cast<size_t>(state.get_thread_index())) % files->size()];
+        loki::CachedMPQFile file = get_samples().cache->get(sample.name);
+
+        loki::bench::do_not_optimize(touch_pages(file.get_span()));
+        bytes += file.get_span().size();
+      }
+    }
+    state.set_bytes_processed(bytes);
+  }
+
+  // The same files as read_all, out of the pack
+  void pack_read_all(loki::bench::State& state, FileKind kind)
+  {
+    const auto* files = get_files(state, kind);
+    const auto& pack_path = loki::bench::get_settings().pack_path;
+    if (files && pack_path.empty()) {
+      state.skip("no --pack file");
+      return;
+    }
+
+    static std::unique_ptr<loki::AssetPack> pack;
+    if (!pack && !pack_path.empty()) {
+      pack = std::make_unique<loki::AssetPack>(pack_path);
+    }
+
+    loki::u64 bytes = 0;
+    while (state.keep_running()) {
+      for (const auto& sample : *files) {
+        const loki::AssetPackEntry* entry = pack->find(sample.name);
+        if (!entry) {
+          continue;
+        }
+
+        loki::MPQFileData data = pack->read(*entry);
+        loki::bench::do_not_optimize(touch_pages(data.get_span()));
+        bytes += data.get_span().size();
+      }
+    }
+    state.set_bytes_processed(bytes);
+  }
+
+  template<FileKind KIND>
+  void pack_read_all_of(loki::bench::State& state)
+  {
+    pack_read_all(state, KIND);
+  }
+
+  template<FileKind KIND>
+  void sfile_read_file_of(loki::bench::State& state)
+  {
+    sfile_read_file(state, KIND);
+  }
+
+  template<FileKind KIND>
+  void mpq_file_read_all_of(loki::bench::State& state)
+  {
+    mpq_file_read_all(state, KIND);
+  }
+
+} // namespace
+
+LOKI_BENCHMARK("mpq/open_chain", open_chain);
+LOKI_BENCHMARK("mpq/has_file", has_file);
+LOKI_BENCHMARK("mpq/sfile_read_file/adt", sfile_read_file_of<FileKind::ADT>);
+LOKI_BENCHMARK("mpq/read_all/adt", mpq_file_read_all_of<FileKind::ADT>);
+LOKI_BENCHMARK("pack/read_all/adt", pack_read_all_of<FileKind::ADT>);
+LOKI_BENCHMARK("mpq/sfile_read_file/blp", sfile_read_file_of<FileKind::BLP>);
+LOKI_BENCHMARK("mpq/read_all/blp", mpq_file_read_all_of<FileKind::BLP>);
+LOKI_BENCHMARK("pack/read_all/blp", pack_read_all_of<FileKind::BLP>);
+LOKI_BENCHMARK("mpq/sfile_read_file/stored", sfile_read_file_of<FileKind::STORED>);
+LOKI_BENCHMARK("mpq/read_all/stored", mpq_file_read_all_of<FileKind::STORED>);
+LOKI_BENCHMARK_THREADS("mpq/concurrent_read/locked", concurrent_read_locked, 1, 2, 4, 8);
+LOKI_BENCHMARK_THREADS("mpq/concurrent_read/pooled", concurrent_read_pooled, 1, 2, 4, 8);
+LOKI_BENCHMARK_THREADS("mpq/concurrent_read/cached", concurrent_read_cached, 1, 2, 4, 8);
@@ -0,0 +1,135 @@
+#include "benchmark.h"
+
+#include "engine/string_manager.h"
+
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <string>
+#include <vector>
+
+namespace {
+
+  // Formats "<prefix>_<run>_<n>" into the buffer, so the measured loop doesn't allocate
+  auto make_unique_string(std::array<char, 64>& buffer, std::string_view prefix, loki::u64 run, loki::u64 n) -> std::string_view
+  {
+    char* end = std::copy(prefix.begin(), prefix.end(), buffer.data());
+    *end++ = '_';
+    end = std::to_chars(end, buffer.data() + buffer.size(), run).ptr;
+    *end++ = '_';
+    end = std::to_chars(end, buffer.data() + buffer.size(), n).ptr;
+    return { buffer.data(), static_cast<std::size_t>(end - buffer.data()) };
+  }
+
+  auto get_existing_strings() -> const std::vector<std::string>&
+  {
+    static std::vector<std::string> strings = []() {
+      std::vector<std::string> result;
+      for (int i = 0; i < 4'096; ++i) {
+        result.push_back("u_existing_uniform_" + std::to_string(i));
+        loki::StringID{ result.back() };
+      }
+      return result;
+    }();
+
+    return strings;
+  }
+
+  void string_id_intern_new(loki::bench::State& state)
+  {
+    // Every call uses a fresh run number, so every iteration takes the insertion path
+    static std::atomic<loki::u64> runs{ 0 };
+    loki::u64 run = runs.fetch_add(1);
+
+    std::array<char, 64> buffer{};
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      loki::StringID id{ make_unique_string(buffer, "bench_new", run, items) };
+      loki::bench::do_not_optimize(id);
+      ++items;
+    }
+    state.set_items_processed(items);
+  }
+
+  void string_id_intern_existing(loki::bench::State& state)
+  {
+    const auto& strings = get_existing_strings();
+
+    // Threads start at different offsets, so they don't walk the same shard in lockstep
+    loki::u64 offset = static_cast<loki::u64>(state.get_thread_index()) * 977;
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      loki::StringID id{ std::string_view(strings[(offset + items) % strings.size()]) };
+      loki::bench::do_not_optimize(id);
+      ++items;
+    }
+    state.set_items_processed(items);
+  }
+
+  void string_id_intern_mixed(loki::bench::State& state)
+  {
+    // One new string in every 16 lookups, roughly what asset loading looks like
+    static std::atomic<loki::u64> runs{ 0 };
+    loki::u64 run = runs.fetch_add(1);
+    const auto& strings = get_existing_strings();
+
+    std::array<char, 64> buffer{};
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      std::string_view string = items % 16 == 0 ? make_unique_string(buffer, "bench_mixed", run, items) : std::string_view(strings[items % strings.size()]);
+      loki::StringID id{ string };
+      loki::bench::do_not_optimize(id);
+      ++items;
+    }
+    state.set_items_processed(items);
+  }
+
+  void string_id_runtime_name(loki::bench::State& state)
+  {
+    // What uniform setters used to do for every call: build a std::string and intern it
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      loki::StringID id{ std::string("model") };
+      loki::bench::do_not_optimize(id);
+      ++items;
+    }
+    state.set_items_processed(items);
+  }
+
+  void string_id_literal(loki::bench::State& state)
+  {
+    using namespace loki::literals;
+
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      auto id = "model"_sid;
+      loki::bench::do_not_optimize(id);
+      ++items;
+    }
+    state.set_items_processed(items);
+  }
+
+  void string_id_to_string_view(loki::bench::State& state)
+  {
+    loki::StringID id{ "model" };
+
+    loki::u64 items = 0;
+    while (state.keep_running()) {
+      auto string = id.to_string_view();
+      loki::bench::do_not_optimize(string);
+      ++items;
+    }
+    state.set_items_processed(items);
+  }
+
+} // namespace
+
+LOKI_BENCHMARK("string_id/intern_new", string_id_intern_new);
+LOKI_BENCHMARK("string_id/intern_existing", string_id_intern_existing);
+LOKI_BENCHMARK("string_id/runtime_name", string_id_runtime_name);
+LOKI_BENCHMARK("string_id/literal", string_id_literal);
+LOKI_BENCHMARK("string_id/to_string_view", string_id_to_string_view);
+LOKI_BENCHMARK_THREADS("string_id/intern_new", string_id_intern_new, 2, 4, 8, 16);
+LOKI_BENCHMARK_THREADS("string_id/intern_existing", string_id_intern_existing, 2, 4, 8, 16);
+LOKI_BENCHMARK_THREADS("string_id/intern_mixed", string_id_intern_mixed, 1, 2, 4, 8, 16);
+LOKI_BENCHMARK_THREADS("string_id/to_string_view", string_id_to_string_view, 2, 4, 8, 16);
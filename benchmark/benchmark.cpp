@@ -0,0 +1,262 @@
+#include "benchmark.h"
+
+#include "engine/crypto/crypto_random.h"
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+  auto get_registry() -> std::vector<loki::bench::Benchmark>&
+  {
+    static std::vector<loki::bench::Benchmark> benchmarks;
+    return benchmarks;
+  }
+
+  struct Measurement
+  {
+    double real_seconds{ 0.0 };
+    double cpu_seconds{ 0.0 };
+    loki::u64 bytes_processed{ 0 };
+    loki::u64 items_processed{ 0 };
+    std::string skip_reason;
+  };
+
+  loki::bench::Settings current_settings;
+
+  auto measure(const loki::bench::Benchmark& benchmark, loki::u64 iterations) -> Measurement
+  {
+    std::vector<loki::bench::State> states;
+    for (int i = 0; i < benchmark.threads; ++i) {
+      states.emplace_back(iterations, benchmark.arg, i, benchmark.threads);
+    }
+
+    // Workers are spawned up front and released together, so thread creation is not measured
+    std::atomic_bool start{ false };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < benchmark.threads; ++i) {
+      workers.emplace_back([&benchmark, &start, &state = states[i]]() {
+        while (!start.load(std::memory_order_acquire)) {
+          std::this_thread::yield();
+        }
+        benchmark.function(state);
+      });
+    }
+
+    std::clock_t cpu_start = std::clock();
+    auto real_start = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+
+    benchmark.function(states.front());
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    auto real_end = std::chrono::steady_clock::now();
+    std::clock_t cpu_end = std::clock();
+
+    Measurement measurement;
+    measurement.real_seconds = std::chrono::duration<double>(real_end - real_start).count();
+    measurement.cpu_seconds = static_cast<double>(cpu_end - cpu_start) / CLOCKS_PER_SEC;
+    for (const auto& state : states) {
+      measurement.bytes_processed += state.get_bytes_processed();
+      measurement.items_processed += state.get_items_processed();
+      if (!state.get_skip_reason().empty()) {
+        measurement.skip_reason = state.get_skip_reason();
+      }
+    }
+    return measurement;
+  }
+
+  auto escape_json(std::string_view string) -> std::string
+  {
+    std::string escaped;
+    escaped.reserve(string.size());
+
+    for (char ch : string) {
+      switch (ch) {
+        case '"':
+          escaped += "\\\"";
+          break;
+        case '\\':
+          escaped += "\\\\";
+          break;
+        case '\n':
+          escaped += "\\n";
+          break;
+        default:
+          escaped += ch;
+          break;
+      }
+    }
+
+    return escaped;
+  }
+
+  auto get_compiler() -> std::string
+  {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_VER);
+#else
+    return "unknown";
+#endif
+  }
+
+} // namespace
+
+auto
+loki::bench::register_benchmark(const std::string& name, loki::bench::Function function, const std::vector<loki::i64>& args) -> bool
+{
+  auto& benchmarks = get_registry();
+
+  if (args.empty()) {
+    benchmarks.push_back({ name, std::move(function), 0 });
+    return true;
+  }
+
+  for (i64 arg : args) {
+    benchmarks.push_back({ name + "/" + std::to_string(arg), function, arg });
+  }
+
+  return true;
+}
+
+auto
+loki::bench::register_threaded_benchmark(const std::string& name, loki::bench::Function function, const std::vector<int>& thread_counts) -> bool
+{
+  auto& benchmarks = get_registry();
+
+  for (int threads : thread_counts) {
+    benchmarks.push_back({ name + "/threads:" + std::to_string(threads), function, 0, threads });
+  }
+
+  return true;
+}
+
+auto
+loki::bench::get_benchmarks() -> const std::vector<Benchmark>&
+{
+  return get_registry();
+}
+
+auto
+loki::bench::get_settings() -> const loki::bench::Settings&
+{
+  return current_settings;
+}
+
+auto
+loki::bench::run_benchmarks(const loki::bench::Settings& settings) -> std::vector<Result>
+{
+  current_settings = settings;
+  std::vector<Result> results;
+
+  for (const auto& benchmark : get_benchmarks()) {
+    if (!settings.filter.empty() && benchmark.name.find(settings.filter) == std::string::npos) {
+      continue;
+    }
+
+    for (int repetition = 0; repetition < settings.repetitions; ++repetition) {
+      // Every repetition draws the same random bytes, so handshakes and keys are identical between runs
+      crypto::set_random_seed(settings.random_seed);
+
+      // Grow the iteration count until a single run takes at least min_time
+      u64 iterations = 1;
+      Measurement measurement = measure(benchmark, iterations);
+      if (!measurement.skip_reason.empty()) {
+        spdlog::info("{:<48} skipped: {}", benchmark.name, measurement.skip_reason);
+        break;
+      }
+
+      while (measurement.real_seconds < settings.min_time && iterations < (u64{ 1 } << 40)) {
+        double multiplier = measurement.real_seconds > 0.0 ? settings.min_time * 1.4 / measurement.real_seconds : 10.0;
+        iterations = static_cast<u64>(static_cast<double>(iterations) * std::clamp(multiplier, 2.0, 10.0));
+        measurement = measure(benchmark, iterations);
+      }
+
+      Result result;
+      result.name = benchmark.name;
+      result.repetition = repetition;
+      result.threads = benchmark.threads;
+      result.iterations = iterations;
+      result.real_time_ns = measurement.real_seconds * 1e9 / static_cast<double>(iterations);
+      result.cpu_time_ns = measurement.cpu_seconds * 1e9 / static_cast<double>(iterations);
+      if (measurement.real_seconds > 0.0) {
+        result.bytes_per_second = static_cast<double>(measurement.bytes_processed) / measurement.real_seconds;
+        result.items_per_second = static_cast<double>(measurement.items_processed) / measurement.real_seconds;
+      }
+
+      spdlog::info("{:<48} {:>14.1f} ns {:>12} iterations", result.name, result.real_time_ns, result.iterations);
+      results.push_back(result);
+    }
+  }
+
+  crypto::reset_random_seed();
+  return results;
+}
+
+auto
+loki::bench::to_json(const loki::bench::Settings& settings, const std::vector<Result>& results) -> std::string
+{
+  // The layout follows Google Benchmark's JSON reporter, so its compare.py can diff two runs
+  std::time_t now = std::time(nullptr);
+  char date[32]{};
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+  std::ostringstream out;
+  out.precision(17);
+
+  out << "{\n";
+  out << "  \"context\": {\n";
+  out << "    \"date\": \"" << date << "\",\n";
+  out << "    \"executable\": \"loki_bench\",\n";
+  out << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+  out << "    \"compiler\": \"" << escape_json(get_compiler()) << "\",\n";
+#ifdef NDEBUG
+  out << "    \"library_build_type\": \"release\",\n";
+#else
+  out << "    \"library_build_type\": \"debug\",\n";
+#endif
+  out << "    \"min_time\": " << settings.min_time << ",\n";
+  out << "    \"random_seed\": " << settings.random_seed << "\n";
+  out << "  },\n";
+  out << "  \"benchmarks\": [";
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& result = results[i];
+
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    {\n";
+    out << "      \"name\": \"" << escape_json(result.name) << "\",\n";
+    out << "      \"run_name\": \"" << escape_json(result.name) << "\",\n";
+    out << "      \"run_type\": \"iteration\",\n";
+    out << "      \"repetitions\": " << settings.repetitions << ",\n";
+    out << "      \"repetition_index\": " << result.repetition << ",\n";
+    out << "      \"threads\": " << result.threads << ",\n";
+    out << "      \"iterations\": " << result.iterations << ",\n";
+    out << "      \"real_time\": " << result.real_time_ns << ",\n";
+    out << "      \"cpu_time\": " << result.cpu_time_ns << ",\n";
+    out << "      \"time_unit\": \"ns\"";
+    if (result.bytes_per_second > 0.0) {
+      out << ",\n      \"bytes_per_second\": " << result.bytes_per_second;
+    }
+    if (result.items_per_second > 0.0) {
+      out << ",\n      \"items_per_second\": " << result.items_per_second;
+    }
+    out << "\n    }";
+  }
+
+  out << "\n  ]\n";
+  out << "}\n";
+
+  return out.str();
+}
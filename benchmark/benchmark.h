@@ -0,0 +1,167 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "engine/utils/types.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace loki::bench {
+
+  class State
+  {
+  public:
+    explicit State(u64 iterations, i64 arg, int thread_index = 0, int threads = 1)
+      : remaining{ iterations }
+      , arg{ arg }
+      , thread_index{ thread_index }
+      , threads{ threads }
+    {
+    }
+
+  public:
+    bool keep_running()
+    {
+      return remaining-- > 0;
+    }
+
+    // For benchmarks that can't run here (no game data), keep_running() is false from now on
+    void skip(std::string reason)
+    {
+      skip_reason = std::move(reason);
+      remaining = 0;
+    }
+
+    auto get_skip_reason() const -> const std::string&
+    {
+      return skip_reason;
+    }
+
+    auto get_arg() const -> i64
+    {
+      return arg;
+    }
+
+    auto get_thread_index() const -> int
+    {
+      return thread_index;
+    }
+
+    auto get_threads() const -> int
+    {
+      return threads;
+    }
+
+    void set_bytes_processed(u64 bytes)
+    {
+      bytes_processed = bytes;
+    }
+
+    void set_items_processed(u64 items)
+    {
+      items_processed = items;
+    }
+
+    auto get_bytes_processed() const -> u64
+    {
+      return bytes_processed;
+    }
+
+    auto get_items_processed() const -> u64
+    {
+      return items_processed;
+    }
+
+  private:
+    u64 remaining;
+    i64 arg;
+    int thread_index;
+    int threads;
+    u64 bytes_processed{ 0 };
+    u64 items_processed{ 0 };
+    std::string skip_reason;
+  };
+
+  using Function = std::function<void(State& state)>;
+
+  struct Benchmark
+  {
+    std::string name;
+    Function function;
+    i64 arg{ 0 };
+    int threads{ 1 };
+  };
+
+  struct Settings
+  {
+    std::string filter;
+    double min_time{ 0.5 };
+    int repetitions{ 1 };
+    u64 random_seed{ 0 };
+    // Game client Data directory, the MPQ benchmarks are skipped without it
+    std::filesystem::path data_path;
+    // Written by loki_repack from the same Data directory, for the pack benchmarks
+    std::filesystem::path pack_path;
+  };
+
+  struct Result
+  {
+    std::string name;
+    int repetition{ 0 };
+    int threads{ 1 };
+    u64 iterations{ 0 };
+    double real_time_ns{ 0.0 };
+    double cpu_time_ns{ 0.0 };
+    double bytes_per_second{ 0.0 };
+    double items_per_second{ 0.0 };
+  };
+
+  auto register_benchmark(const std::string& name, Function function, const std::vector<i64>& args = {}) -> bool;
+  // Runs the function on every thread at once, iterations and processed counts are per thread
+  auto register_threaded_benchmark(const std::string& name, Function function, const std::vector<int>& thread_counts) -> bool;
+  auto get_benchmarks() -> const std::vector<Benchmark>&;
+  // Of the run in progress
+  auto get_settings() -> const Settings&;
+
+  auto run_benchmarks(const Settings& settings) -> std::vector<Result>;
+  auto to_json(const Settings& settings, const std::vector<Result>& results) -> std::string;
+
+  // Keeps the compiler from discarding a value that is computed but never used
+  template<typename T>
+  inline void do_not_optimize(const T& value)
+  {
+#ifdef _MSC_VER
+    static_cast<void>(*const_cast<volatile const char*>(reinterpret_cast<const volatile char*>(&value)));
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+  }
+
+  inline void clobber_memory()
+  {
+#ifdef _MSC_VER
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : : "memory");
+#endif
+  }
+
+} // namespace loki::bench
+
+#define LOKI_BENCH_CONCAT_IMPL(a, b) a##b
+#define LOKI_BENCH_CONCAT(a, b)      LOKI_BENCH_CONCAT_IMPL(a, b)
+
+// Registers a benchmark at static-init time, optional trailing values are passed one per run as State::get_arg()
+#define LOKI_BENCHMARK(name, function, ...) \
+  static const bool LOKI_BENCH_CONCAT(loki_benchmark_, __LINE__) = loki::bench::register_benchmark(name, function, { __VA_ARGS__ })
+
+// Registers one run per thread count, named "<name>/threads:<count>"
+#define LOKI_BENCHMARK_THREADS(name, function, ...) \
+  static const bool LOKI_BENCH_CONCAT(loki_benchmark_, __LINE__) = loki::bench::register_threaded_benchmark(name, function, { __VA_ARGS__ })
@@ -0,0 +1,59 @@
+#include <mimalloc-new-delete.h>
+
+#include <CLI/CLI.hpp>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <fstream>
+#include <iostream>
+
+#include "benchmark.h"
+
+int
+main(int argc, char* argv[])
+{
+  CLI::App app{ "loki Engine benchmarks" };
+  argv = app.ensure_utf8(argv);
+
+  loki::bench::Settings settings;
+  std::string out_path;
+  bool list = false;
+
+  app.add_option("--filter", settings.filter, "Run only benchmarks whose name contains this string");
+  app.add_option("--min-time", settings.min_time, "Minimum seconds per measurement");
+  app.add_option("--repetitions", settings.repetitions, "Number of measurements per benchmark");
+  app.add_option("--random-seed", settings.random_seed, "Seed for the deterministic crypto RNG");
+  app.add_option("--data", settings.data_path, "Game client Data directory for the MPQ benchmarks");
+  app.add_option("--pack", settings.pack_path, "Asset pack of that Data directory for the pack benchmarks");
+  app.add_option("--out", out_path, "Write JSON results to this file instead of stdout");
+  app.add_flag("--list", list, "List benchmark names and exit");
+  CLI11_PARSE(app, argc, argv)
+
+  // Keep stdout clean for the JSON report
+  spdlog::set_default_logger(spdlog::stderr_color_mt("bench"));
+
+  if (list) {
+    for (const auto& benchmark : loki::bench::get_benchmarks()) {
+      std::cout << benchmark.name << "\n";
+    }
+    return 0;
+  }
+
+  auto results = loki::bench::run_benchmarks(settings);
+  auto json = loki::bench::to_json(settings, results);
+
+  if (out_path.empty()) {
+    std::cout << json;
+    return 0;
+  }
+
+  std::ofstream file(out_path, std::ios::binary);
+  if (!file) {
+    spdlog::error("Failed to open {} for writing!", out_path);
+    return 1;
+  }
+
+  file << json;
+  spdlog::info("Results written to {}", out_path);
+  return 0;
+}
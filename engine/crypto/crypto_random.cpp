@@ -1,13 +1,153 @@
-#pragma once
-
 #include "crypto_random.h"
+
+#include "crypto_hash.h"
 #include "libassert/assert.hpp"
 
+#include <openssl/crypto.h>
 #include <openssl/rand.h>
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+
+namespace {
+
+  constexpr size_t RANDOM_BLOCK_SIZE = 0x1000;
+
+  std::mutex random_mutex;
+  std::optional<loki::u64> random_seed;
+  // Bumped on every mode switch, threads compare it against their own copy and re-key lazily
+  std::atomic<loki::u64> random_epoch{ 0 };
+
+  class RandomPool
+  {
+  public:
+    ~RandomPool()
+    {
+      OPENSSL_cleanse(block.data(), block.size());
+      if (context) {
+        EVP_CIPHER_CTX_free(context);
+      }
+    }
+
+  public:
+    void fill(loki::u8* buf, size_t len)
+    {
+      sync();
+
+      while (len > 0) {
+        if (pos == block.size()) {
+          refill();
+        }
+
+        size_t n = std::min(len, block.size() - pos);
+        std::memcpy(buf, block.data() + pos, n);
+        // Never hand out the same bytes twice and don't keep them around after use
+        OPENSSL_cleanse(block.data() + pos, n);
+
+        pos += n;
+        buf += n;
+        len -= n;
+      }
+    }
+
+  private:
+    void sync()
+    {
+      if (random_epoch.load(std::memory_order_acquire) == epoch) {
+        return;
+      }
+
+      std::optional<loki::u64> seed;
+      {
+        std::lock_guard lock(random_mutex);
+        seed = random_seed;
+        epoch = random_epoch.load(std::memory_order_relaxed);
+      }
+
+      rekey(seed);
+    }
+
+    void rekey(std::optional<loki::u64> seed)
+    {
+      OPENSSL_cleanse(block.data(), block.size());
+      pos = block.size();
+
+      if (context) {
+        EVP_CIPHER_CTX_free(context);
+        context = nullptr;
+      }
+
+      if (!seed) {
+        return;
+      }
+
+      std::array<loki::u8, sizeof(loki::u64)> seed_bytes{};
+      for (size_t i = 0; i < seed_bytes.size(); ++i) {
+        seed_bytes[i] = static_cast<loki::u8>(*seed >> (8 * i));
+      }
+
+      auto key = loki::crypto::SHA256::get_digest_of(std::string_view("loki-drbg"), seed_bytes);
+      std::array<loki::u8, 16> iv{};
+
+      context = EVP_CIPHER_CTX_new();
+      loki::i32 result = EVP_EncryptInit_ex(context, EVP_chacha20(), nullptr, key.data(), iv.data());
+      ASSERT(result == 1);
+      OPENSSL_cleanse(key.data(), key.size());
+    }
+
+    void refill()
+    {
+      if (context) {
+        // The keystream is the cipher applied to zeroes, the block is already zeroed by the cleanse above
+        loki::i32 outlen = 0;
+        loki::i32 result = EVP_EncryptUpdate(context, block.data(), &outlen, block.data(), (int)block.size());
+        ASSERT(result == 1 && outlen == (int)block.size());
+      } else {
+        loki::i32 result = RAND_bytes(block.data(), static_cast<loki::i32>(block.size()));
+        ASSERT(result == 1, "Not enough randomness in OpenSSL's entropy pool. What in the world are you running on?");
+      }
+
+      pos = 0;
+    }
+
+  private:
+    std::array<loki::u8, RANDOM_BLOCK_SIZE> block{};
+    size_t pos{ RANDOM_BLOCK_SIZE };
+    loki::u64 epoch{ 0 };
+    EVP_CIPHER_CTX* context{};
+  };
+
+  thread_local RandomPool pool;
+
+} // namespace
+
 void
 loki::crypto::get_random_bytes(loki::u8* buf, size_t len)
 {
-  i32 result = RAND_bytes(buf, static_cast<i32>(len));
-  DEBUG_ASSERT(result == 1, "Not enough randomness in OpenSSL's entropy pool. What in the world are you running on?");
+  pool.fill(buf, len);
+}
+
+void
+loki::crypto::set_random_seed(loki::u64 seed)
+{
+  std::lock_guard lock(random_mutex);
+  random_seed = seed;
+  random_epoch.fetch_add(1, std::memory_order_release);
+}
+
+void
+loki::crypto::reset_random_seed()
+{
+  std::lock_guard lock(random_mutex);
+  random_seed.reset();
+  random_epoch.fetch_add(1, std::memory_order_release);
+}
+
+auto
+loki::crypto::is_random_deterministic() -> bool
+{
+  std::lock_guard lock(random_mutex);
+  return random_seed.has_value();
 }
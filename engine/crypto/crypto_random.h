@@ -6,6 +6,8 @@
 
 namespace loki::crypto {
 
+  // Random bytes are served from a per-thread block that is refilled from the OS CSPRNG (or from the
+  // seeded keystream, see below) in large chunks, so small requests never reach OpenSSL directly.
   void get_random_bytes(u8* buf, size_t len);
 
   template<typename Container>
@@ -22,4 +24,11 @@ namespace loki::crypto {
     return arr;
   }
 
+  // Deterministic mode for benchmarks and regression tests ONLY: every thread switches to a ChaCha20
+  // keystream derived from the seed, so the N-th byte drawn on a thread depends only on the seed and N.
+  // Handshakes and captured sessions then replay bit-for-bit. Never enable it for real connections.
+  void set_random_seed(u64 seed);
+  void reset_random_seed();
+  auto is_random_deterministic() -> bool;
+
 } // namespace loki::crypto
@@ -0,0 +1,79 @@
+#include "dbc_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "spdlog/spdlog.h"
+
+loki::DBCFile::DBCFile(loki::MPQFileData file_data)
+  : data{ std::move(file_data) }
+{
+  auto bytes = data.get_span();
+  if (bytes.size() < sizeof(DBCHeader)) {
+    spdlog::error("DBC file is too small for its header: {} bytes", bytes.size());
+    return;
+  }
+
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  u64 records_size = u64{ header.record_count } * header.record_size;
+  if (header.magic != MAGIC || header.record_size != header.field_count * sizeof(u32)) {
+    spdlog::error("Not a WDBC file, or its records aren't made of 4 byte fields");
+    return;
+  }
+
+  if (sizeof(DBCHeader) + records_size + header.string_block_size != bytes.size()) {
+    spdlog::error("DBC file is {} bytes, its header says {}", bytes.size(), sizeof(DBCHeader) + records_size + header.string_block_size);
+    return;
+  }
+
+  // Records are read as structs of 4 byte fields
+  if (reinterpret_cast<uintptr_t>(bytes.data()) % alignof(u32) != 0) {
+    copy.assign(bytes.begin(), bytes.end());
+    bytes = copy;
+  }
+
+  records = bytes.subspan(sizeof(DBCHeader), static_cast<size_t>(records_size));
+  auto string_block = bytes.subspan(sizeof(DBCHeader) + static_cast<size_t>(records_size));
+  strings = { reinterpret_cast<const char*>(string_block.data()), string_block.size() };
+  valid = true;
+}
+
+loki::DBCFile::DBCFile(loki::DBCFile&& other) noexcept
+  : data{ std::move(other.data) }
+  , copy{ std::move(other.copy) }
+  , header{ std::exchange(other.header, {}) }
+  , records{ std::exchange(other.records, {}) }
+  , strings{ std::exchange(other.strings, {}) }
+  , valid{ std::exchange(other.valid, false) }
+{
+}
+
+loki::DBCFile&
+loki::DBCFile::operator=(loki::DBCFile&& other) noexcept
+{
+  if (this != &other) {
+    data = std::move(other.data);
+    copy = std::move(other.copy);
+    header = std::exchange(other.header, {});
+    records = std::exchange(other.records, {});
+    strings = std::exchange(other.strings, {});
+    valid = std::exchange(other.valid, false);
+  }
+
+  return *this;
+}
+
+auto
+loki::DBCFile::get_string(loki::u32 offset) const -> std::string_view
+{
+  if (offset >= strings.size()) {
+    return {};
+  }
+
+  // The block ends with a null, but a broken file shouldn't take a read past it
+  auto rest = strings.subspan(offset);
+  const void* end = std::memchr(rest.data(), 0, rest.size());
+  size_t length = end ? static_cast<size_t>(static_cast<const char*>(end) - rest.data()) : rest.size();
+  return { rest.data(), length };
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "engine/datasource/mpq/mpq_file.h"
+#include "engine/memory/memory_domain.h"
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  // Field types of a record schema, each 4 bytes wide as in the file
+
+  // Offset into the string block
+  struct DBCString
+  {
+    u32 offset;
+  };
+
+  // The 3.3.5 client's locales, in the order of a localized string's offsets
+  enum class DBCLocale : u8
+  {
+    EN_US = 0,
+    KO_KR = 1,
+    FR_FR = 2,
+    DE_DE = 3,
+    ZH_CN = 4,
+    ZH_TW = 5,
+    ES_ES = 6,
+    ES_MX = 7,
+    RU_RU = 8,
+  };
+
+  // A string per locale, a client only fills in its own, then a mask of the ones that are set
+  struct DBCLocString
+  {
+    std::array<u32, 16> offsets;
+    u32 flags;
+  };
+
+  struct DBCHeader
+  {
+    u32 magic;
+    u32 record_count;
+    // Of 4 bytes each
+    u32 field_count;
+    u32 record_size;
+    u32 string_block_size;
+  };
+
+  // A WDBC file as it is: a header, fixed-size records, then a block of null-terminated strings the
+  // records point into. Records and strings are read in place, only a file that isn't 4 byte aligned in
+  // memory (a mapped MPQ file can be anywhere) is copied first. As long as the data is valid, which for a
+  // mapped file is as long as its archive or pack is open.
+  class DBCFile
+  {
+  public:
+    static constexpr u32 MAGIC = 0x43'42'44'57; // "WDBC"
+
+  public:
+    explicit DBCFile() = default;
+    // Checks the header against the data's size, invalid when they don't agree
+    explicit DBCFile(MPQFileData data);
+    // The records stay where they are, neither the buffer nor the copy moves. The other file is invalid after.
+    DBCFile(DBCFile&& other) noexcept;
+    DBCFile& operator=(DBCFile&& other) noexcept;
+
+  public:
+    auto is_valid() const -> bool
+    {
+      return valid;
+    }
+
+    auto get_header() const -> const DBCHeader&
+    {
+      return header;
+    }
+
+    auto get_record_count() const -> u32
+    {
+      return header.record_count;
+    }
+
+    // Every record's bytes, back to back, 4 byte aligned
+    auto get_records() const -> std::span<const std::byte>
+    {
+      return records;
+    }
+
+    // Empty when the offset is out of the string block
+    auto get_string(u32 offset) const -> std::string_view;
+
+    auto get_string(DBCString string) const -> std::string_view
+    {
+      return get_string(string.offset);
+    }
+
+    auto get_string(const DBCLocString& string, DBCLocale locale = DBCLocale::EN_US) const -> std::string_view
+    {
+      return get_string(string.offsets[static_cast<size_t>(locale)]);
+    }
+
+  private:
+    MPQFileData data;
+    std::pmr::vector<std::byte> copy{ get_memory_resource(MemoryDomain::ASSETS) };
+    DBCHeader header{};
+    std::span<const std::byte> records;
+    std::span<const char> strings;
+    bool valid{ false };
+  };
+
+} // namespace loki
@@ -0,0 +1,20 @@
+#include "dbc_hot_columns.h"
+
+#include "engine/time/profiler.h"
+
+loki::SpellTimingColumns::SpellTimingColumns(const loki::DBCTable<loki::SpellRecord>& spells, const loki::DBCTable<loki::SpellCastTimesRecord>& cast_times,
+                                             const loki::DBCTable<loki::SpellDurationRecord>& durations)
+{
+  LOKI_PROFILE_ZONE("Resolve spell timings");
+
+  cast_times_ms.reserve(spells.size());
+  durations_ms.reserve(spells.size());
+
+  for (const SpellRecord& spell : spells) {
+    const SpellCastTimesRecord* cast_time = cast_times.find(spell.casting_time_index);
+    cast_times_ms.push_back(cast_time ? cast_time->base : NONE);
+
+    const SpellDurationRecord* duration = durations.find(spell.duration_index);
+    durations_ms.push_back(duration ? duration->base : NONE);
+  }
+}
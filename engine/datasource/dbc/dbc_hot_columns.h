@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <memory_resource>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "dbc_schemas.h"
+#include "dbc_table.h"
+#include "engine/memory/memory_domain.h"
+
+namespace loki {
+
+  // A few of a table's fields copied out into an array each, in the table's order, so a query over every
+  // record reads only the fields it needs instead of whole records (a Spell record is 936 bytes). Rows
+  // are the table's rows, the table's DBCIdIndex finds them by id. Fields are copied as they are, an index
+  // into another table stays an index (SpellTimingColumns resolves the spell ones). Members are pointers
+  // to fields of T:
+  //
+  //   DBCHotColumns<SpellRecord, &SpellRecord::casting_time_index> columns{ spells };
+  //   std::span<const u32> cast_time_indices = columns.get<&SpellRecord::casting_time_index>();
+  template<IsDBCRecord T, auto... Members>
+    requires(sizeof...(Members) > 0 && (std::is_member_object_pointer_v<decltype(Members)> && ...))
+  class DBCHotColumns
+  {
+    template<auto Member>
+    using FieldType = std::remove_cvref_t<decltype(std::declval<const T&>().*Member)>;
+
+    // A member pointer of another type can't be compared with, it can't be the same field either
+    template<auto A, auto B>
+    static consteval auto is_same_member() -> bool
+    {
+      if constexpr (std::is_same_v<decltype(A), decltype(B)>) {
+        return A == B;
+      } else {
+        return false;
+      }
+    }
+
+    template<auto Member>
+    static consteval auto get_column_index() -> size_t
+    {
+      constexpr std::array<bool, sizeof...(Members)> matches{ is_same_member<Members, Member>()... };
+      for (size_t i = 0; i < matches.size(); ++i) {
+        if (matches[i]) {
+          return i;
+        }
+      }
+      return sizeof...(Members);
+    }
+
+  public:
+    explicit DBCHotColumns() = default;
+
+    // One pass over the records, each one is read once for all of the columns
+    explicit DBCHotColumns(const DBCTable<T>& table)
+    {
+      std::apply([&table](auto&... column) {
+        (column.reserve(table.size()), ...);
+      }, columns);
+
+      for (const T& record : table) {
+        std::apply([&record](auto&... column) {
+          (column.push_back(record.*Members), ...);
+        }, columns);
+      }
+    }
+
+  public:
+    auto size() const -> size_t
+    {
+      return std::get<0>(columns).size();
+    }
+
+    template<auto Member>
+    auto get() const -> std::span<const FieldType<Member>>
+    {
+      constexpr size_t index = get_column_index<Member>();
+      static_assert(index < sizeof...(Members), "The field isn't one of the columns");
+      return std::get<index>(columns);
+    }
+
+  private:
+    std::tuple<std::pmr::vector<FieldType<Members>>...> columns{ std::pmr::vector<FieldType<Members>>{ get_memory_resource(MemoryDomain::ASSETS) }... };
+  };
+
+  // Every spell's cast time and duration in milliseconds, in the Spell table's order. The Spell records only
+  // have indices into SpellCastTimes.dbc and SpellDuration.dbc, those are resolved once here so a bulk query
+  // scans two arrays instead of looking both up per row. The values are the tables' base ones, per-level
+  // scaling is left to whoever knows the caster's level.
+  class SpellTimingColumns
+  {
+  public:
+    // A spell that casts instantly, or has no duration, has 0 there. So does one whose index isn't in the table.
+    static constexpr i32 NONE = 0;
+    // SpellDuration.dbc's value for an aura that doesn't run out
+    static constexpr i32 UNLIMITED = -1;
+
+  public:
+    explicit SpellTimingColumns() = default;
+    explicit SpellTimingColumns(const DBCTable<SpellRecord>& spells, const DBCTable<SpellCastTimesRecord>& cast_times,
+                                const DBCTable<SpellDurationRecord>& durations);
+
+  public:
+    auto size() const -> size_t
+    {
+      return cast_times_ms.size();
+    }
+
+    auto get_cast_times_ms() const -> std::span<const i32>
+    {
+      return cast_times_ms;
+    }
+
+    auto get_durations_ms() const -> std::span<const i32>
+    {
+      return durations_ms;
+    }
+
+  private:
+    std::pmr::vector<i32> cast_times_ms{ get_memory_resource(MemoryDomain::ASSETS) };
+    std::pmr::vector<i32> durations_ms{ get_memory_resource(MemoryDomain::ASSETS) };
+  };
+
+} // namespace loki
@@ -0,0 +1,65 @@
+#include "dbc_index.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "engine/time/profiler.h"
+#include "spdlog/spdlog.h"
+
+loki::DBCIdIndex::DBCIdIndex(std::span<const loki::u32> ids)
+{
+  LOKI_PROFILE_ZONE("Build DBC id index");
+
+  if (ids.empty()) {
+    return;
+  }
+
+  auto [min, max] = std::minmax_element(ids.begin(), ids.end());
+  u64 spread = u64{ *max } - *min + 1;
+  if (spread <= u64{ MAX_DENSE_SPREAD } * ids.size()) {
+    min_id = *min;
+    dense.assign(static_cast<size_t>(spread), NO_ROW);
+    size_t duplicates = 0;
+    for (u32 row = 0; row < ids.size(); ++row) {
+      u32& slot = dense[ids[row] - min_id];
+      if (slot == NO_ROW) {
+        slot = row;
+      } else {
+        duplicates++;
+      }
+    }
+
+    if (duplicates > 0) {
+      spdlog::warn("DBC table has {} rows with an id another row has already", duplicates);
+    }
+    return;
+  }
+
+  // The hash takes each key once
+  std::vector<u64> keys;
+  std::vector<u32> rows;
+  std::unordered_set<u32> seen;
+  keys.reserve(ids.size());
+  rows.reserve(ids.size());
+  for (u32 row = 0; row < ids.size(); ++row) {
+    if (seen.insert(ids[row]).second) {
+      keys.push_back(ids[row]);
+      rows.push_back(row);
+    }
+  }
+
+  if (keys.size() != ids.size()) {
+    spdlog::warn("DBC table has {} rows with an id another row has already", ids.size() - keys.size());
+  }
+
+  hash = PerfectHash::build(keys);
+  if (!hash.is_valid()) {
+    spdlog::error("No perfect hash found for {} DBC ids", keys.size());
+    return;
+  }
+
+  slots.resize(hash.get_slot_count());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    slots[hash.get_key_slot(i)] = { static_cast<u32>(keys[i]), rows[i] };
+  }
+}
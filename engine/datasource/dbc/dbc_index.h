@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "engine/memory/memory_domain.h"
+#include "engine/utils/perfect_hash.h"
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  // Rows of a table by their id, built once when the table is loaded. Ids that are close together get a
+  // plain array from the lowest id up, sparse ones (Spell and Item go up to the hundreds of thousands
+  // with gaps) a PerfectHash with the id kept next to the row. Either way a lookup doesn't probe.
+  class DBCIdIndex
+  {
+  public:
+    static constexpr u32 NO_ROW = 0xFFFF'FFFF;
+    // Slots per row the array may have before the hash is used. The hash is about 10 bytes per row, the
+    // array 4 per slot, it's given a bit more than it breaks even at because it's a read less.
+    static constexpr u32 MAX_DENSE_SPREAD = 4;
+
+  public:
+    explicit DBCIdIndex() = default;
+    // ids[row] is the row's id. When an id is there more than once, the first row has it.
+    explicit DBCIdIndex(std::span<const u32> ids);
+
+  public:
+    // NO_ROW when there's no row with the id
+    auto find(u32 id) const -> u32
+    {
+      if (is_dense()) {
+        u32 index = id - min_id;
+        return index < dense.size() ? dense[index] : NO_ROW;
+      }
+
+      if (!hash.is_valid()) {
+        return NO_ROW;
+      }
+
+      const Slot& slot = slots[hash.find_slot(id)];
+      return slot.id == id ? slot.row : NO_ROW;
+    }
+
+    auto is_dense() const -> bool
+    {
+      return !dense.empty();
+    }
+
+    auto get_memory_size() const -> size_t
+    {
+      return dense.size() * sizeof(u32) + slots.size() * sizeof(Slot) + hash.get_seeds().size() * sizeof(u32);
+    }
+
+  private:
+    // An empty slot has NO_ROW, so an id of 0 doesn't find it
+    struct Slot
+    {
+      u32 id{ 0 };
+      u32 row{ NO_ROW };
+    };
+
+    u32 min_id{ 0 };
+    std::pmr::vector<u32> dense{ get_memory_resource(MemoryDomain::ASSETS) };
+    PerfectHash hash;
+    std::pmr::vector<Slot> slots{ get_memory_resource(MemoryDomain::ASSETS) };
+  };
+
+} // namespace loki
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+
+#include "dbc_file.h"
+#include "engine/utils/types.h"
+
+// Record layouts of the 3.3.5a (12340) client, field for field. DBCTable checks each against FIELD_COUNT
+// when it's compiled, and against the file's header when it's loaded.
+
+namespace loki {
+
+  struct MapRecord
+  {
+    static constexpr std::string_view FILE_NAME = "DBFilesClient\\Map.dbc";
+    static constexpr u32 FIELD_COUNT = 66;
+
+    u32 id;
+    DBCString directory;
+    u32 instance_type;
+    u32 flags;
+    u32 pvp;
+    DBCLocString name;
+    u32 area_table_id;
+    DBCLocString description_horde;
+    DBCLocString description_alliance;
+    u32 loading_screen_id;
+    float minimap_icon_scale;
+    i32 corpse_map_id;
+    float corpse_x;
+    float corpse_y;
+    i32 time_of_day_override;
+    u32 expansion_id;
+    u32 raid_offset;
+    u32 max_players;
+  };
+
+  struct AreaTableRecord
+  {
+    static constexpr std::string_view FILE_NAME = "DBFilesClient\\AreaTable.dbc";
+    static constexpr u32 FIELD_COUNT = 36;
+
+    u32 id;
+    u32 map_id;
+    u32 parent_area_id;
+    u32 area_bit;
+    u32 flags;
+    u32 sound_provider_preference;
+    u32 sound_provider_preference_underwater;
+    u32 ambience_id;
+    u32 zone_music;
+    u32 intro_sound;
+    i32 exploration_level;
+    DBCLocString name;
+    u32 faction_group_mask;
+    std::array<u32, 4> liquid_type_id;
+    float min_elevation;
+    float ambient_multiplier;
+    u32 light_id;
+  };
+
+  struct CreatureDisplayInfoRecord
+  {
+    static constexpr std::string_view FILE_NAME = "DBFilesClient\\CreatureDisplayInfo.dbc";
+    static constexpr u32 FIELD_COUNT = 16;
+
+    u32 id;
+    u32 model_id;
+    u32 sound_id;
+    u32 extended_display_info_id;
+    float model_scale;
+    u32 model_alpha;
+    std::array<DBCString, 3> texture_variations;
+    DBCString portrait_texture_name;
+    i32 size_class;
+    u32 blood_id;
+    u32 npc_sound_id;
+    u32 particle_color_id;
+    u32 creature_geoset_data;
+    u32 object_effect_package_id;
+  };
+
+  struct SpellRecord
+  {
+    static constexpr std::string_view FILE_NAME = "DBFilesClient\\Spell.dbc";
+    static constexpr u32 FIELD_COUNT = 234;
+    static constexpr size_t EFFECT_COUNT = 3;
+
+    u32 id;
+    u32 category;
+    u32 dispel;
+    u32 mechanic;
+    std::array<u32, 8> attributes;
+    // A 64 bit mask each, low word first
+    std::array<u32, 2> stances;
+    std::array<u32, 2> stances_excluded;
+    u32 targets;
+    u32 target_creature_type;
+    u32 requires_spell_focus;
+    u32 facing_caster_flags;
+    u32 caster_aura_state;
+    u32 target_aura_state;
+    u32 caster_aura_state_excluded;
+    u32 target_aura_state_excluded;
+    u32 caster_aura_spell;
+    u32 target_aura_spell;
+    u32 caster_aura_spell_excluded;
+    u32 target_aura_spell_excluded;
+    u32 casting_time_index;
+    u32 recovery_time;
+    u32 category_recovery_time;
+    u32 interrupt_flags;
+    u32 aura_interrupt_flags;
+    u32 channel_interrupt_flags;
+    u32 proc_flags;
+    u32 proc_chance;
+    u32 proc_charges;
+    u32 max_level;
+    u32 base_level;
+    u32 spell_level;
+    u32 duration_index;
+    u32 power_type;
+    u32 mana_cost;
+    u32 mana_cost_per_level;
+    u32 mana_per_second;
+    u32 mana_per_second_per_level;
+    u32 range_index;
+    float speed;
+    u32 modal_next_spell;
+    u32 stack_amount;
+    std::array<u32, 2> totems;
+    std::array<i32, 8> reagents;
+    std::array<u32, 8> reagent_counts;
+    i32 equipped_item_class;
+    i32 equipped_item_subclass_mask;
+    i32 equipped_item_inventory_type_mask;
+    std::array<u32, EFFECT_COUNT> effects;
+    std::array<i32, EFFECT_COUNT> effect_die_sides;
+    std::array<float, EFFECT_COUNT> effect_real_points_per_level;
+    std::array<i32, EFFECT_COUNT> effect_base_points;
+    std::array<u32, EFFECT_COUNT> effect_mechanics;
+    std::array<u32, EFFECT_COUNT> effect_implicit_targets_a;
+    std::array<u32, EFFECT_COUNT> effect_implicit_targets_b;
+    std::array<u32, EFFECT_COUNT> effect_radius_indices;
+    std::array<u32, EFFECT_COUNT> effect_aura_types;
+    std::array<u32, EFFECT_COUNT> effect_amplitudes;
+    std::array<float, EFFECT_COUNT> effect_value_multipliers;
+    std::array<u32, EFFECT_COUNT> effect_chain_targets;
+    std::array<u32, EFFECT_COUNT> effect_item_types;
+    std::array<i32, EFFECT_COUNT> effect_misc_values;
+    std::array<i32, EFFECT_COUNT> effect_misc_values_b;
+    std::array<u32, EFFECT_COUNT> effect_trigger_spells;
+    std::array<float, EFFECT_COUNT> effect_points_per_combo_point;
+    // A 96 bit mask per effect
+    std::array<u32, EFFECT_COUNT * 3> effect_spell_class_masks;
+    std::array<u32, 2> spell_visuals;
+    u32 spell_icon_id;
+    u32 active_icon_id;
+    u32 spell_priority;
+    DBCLocString name;
+    DBCLocString rank;
+    DBCLocString description;
+    DBCLocString tooltip;
+    u32 mana_cost_percentage;
+    u32 start_recovery_category;
+    u32 start_recovery_time;
+    u32 max_target_level;
+    u32 spell_family_name;
+    std::array<u32, 3> spell_family_flags;
+    u32 max_affected_targets;
+    u32 damage_class;
+    u32 prevention_type;
+    i32 stance_bar_order;
+    std::array<float, EFFECT_COUNT> effect_damage_multipliers;
+    u32 min_faction_id;
+    u32 min_reputation;
+    u32 required_aura_vision;
+    std::array<u32, 2> totem_categories;
+    i32 area_group_id;
+    u32 school_mask;
+    u32 rune_cost_id;
+    u32 spell_missile_id;
+    u32 power_display_id;
+    std::array<float, EFFECT_COUNT> effect_bonus_multipliers;
+    u32 spell_description_variable_id;
+    u32 spell_difficulty_id;
+  };
+
+  // SpellRecord::casting_time_index, in milliseconds
+  struct SpellCastTimesRecord
+  {
+    static constexpr std::string_view FILE_NAME = "DBFilesClient\\SpellCastTimes.dbc";
+    static constexpr u32 FIELD_COUNT = 4;
+
+    u32 id;
+    i32 base;
+    i32 per_level;
+    i32 minimum;
+  };
+
+  // SpellRecord::duration_index, in milliseconds, -1 for one that doesn't run out
+  struct SpellDurationRecord
+  {
+    static constexpr std::string_view FILE_NAME = "DBFilesClient\\SpellDuration.dbc";
+    static constexpr u32 FIELD_COUNT = 4;
+
+    u32 id;
+    i32 base;
+    i32 per_level;
+    i32 maximum;
+  };
+
+} // namespace loki
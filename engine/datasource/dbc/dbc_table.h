@@ -0,0 +1,232 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "dbc_file.h"
+#include "dbc_index.h"
+#include "engine/datasource/mpq/mpq_chain.h"
+#include "engine/datasource/pack/asset_pack.h"
+#include "pfr.hpp"
+#include "spdlog/spdlog.h"
+
+namespace loki {
+
+  // How many of the file's 4 byte fields a schema field takes, 0 for a type a schema can't have
+  template<typename T>
+  struct DBCColumns
+  {
+    static constexpr u32 COUNT = 0;
+  };
+
+  template<>
+  struct DBCColumns<u32>
+  {
+    static constexpr u32 COUNT = 1;
+  };
+
+  template<>
+  struct DBCColumns<i32>
+  {
+    static constexpr u32 COUNT = 1;
+  };
+
+  template<>
+  struct DBCColumns<float>
+  {
+    static constexpr u32 COUNT = 1;
+  };
+
+  template<>
+  struct DBCColumns<DBCString>
+  {
+    static constexpr u32 COUNT = 1;
+  };
+
+  template<>
+  struct DBCColumns<DBCLocString>
+  {
+    static constexpr u32 COUNT = 17;
+  };
+
+  template<typename T, size_t N>
+  struct DBCColumns<std::array<T, N>>
+  {
+    static constexpr u32 COUNT = DBCColumns<T>::COUNT * N;
+  };
+
+  // 0 as soon as one of the fields isn't a DBC field type
+  template<typename T, size_t... I>
+  consteval auto count_dbc_columns(std::index_sequence<I...>) -> u32
+  {
+    constexpr bool all_fields = ((DBCColumns<pfr::tuple_element_t<I, T>>::COUNT > 0) && ...);
+    return all_fields ? (DBCColumns<pfr::tuple_element_t<I, T>>::COUNT + ... + 0) : 0;
+  }
+
+  // An aggregate of DBC field types, in the file's order, that knows its file and how many fields it has
+  template<typename T>
+  concept IsDBCRecord = std::is_aggregate_v<T> && std::is_trivially_copyable_v<T> && requires {
+    { T::FILE_NAME } -> std::convertible_to<std::string_view>;
+    { T::FIELD_COUNT } -> std::convertible_to<u32>;
+  };
+
+  // Records that start with their id, which is nearly all of them, get looked up by it
+  template<typename T>
+  concept HasDBCId = requires(const T& record) {
+    { record.id } -> std::same_as<const u32&>;
+  };
+
+  // The records of a DBC file as T, read in place. The schema is checked against FIELD_COUNT when it is
+  // compiled, the file against the schema when it is loaded, and a schema with an id gets its DBCIdIndex
+  // then too.
+  template<IsDBCRecord T>
+  class DBCTable
+  {
+    static_assert(count_dbc_columns<T>(std::make_index_sequence<pfr::tuple_size_v<T>>{}) == T::FIELD_COUNT,
+                  "The schema's fields don't add up to FIELD_COUNT, or one of them isn't a DBC field type");
+    static_assert(sizeof(T) == T::FIELD_COUNT * sizeof(u32), "The schema has padding between its fields");
+    static_assert(alignof(T) == alignof(u32));
+
+  public:
+    explicit DBCTable() = default;
+
+    explicit DBCTable(MPQFileData data)
+      : file{ std::move(data) }
+    {
+      if (!file.is_valid()) {
+        return;
+      }
+
+      const DBCHeader& header = file.get_header();
+      if (header.field_count != T::FIELD_COUNT || header.record_size != sizeof(T)) {
+        spdlog::error("{} has {} fields per record, the schema {}", T::FILE_NAME, header.field_count, T::FIELD_COUNT);
+        return;
+      }
+
+      auto bytes = file.get_records();
+      records = { reinterpret_cast<const T*>(bytes.data()), header.record_count };
+      valid = true;
+
+      if constexpr (HasDBCId<T>) {
+        std::vector<u32> ids(records.size());
+        for (size_t row = 0; row < records.size(); ++row) {
+          ids[row] = records[row].id;
+        }
+        index = DBCIdIndex{ ids };
+      }
+    }
+
+    // The other table is invalid and empty after, its records are this one's now
+    DBCTable(DBCTable&& other) noexcept
+      : file{ std::move(other.file) }
+      , records{ std::exchange(other.records, {}) }
+      , index{ std::exchange(other.index, DBCIdIndex{}) }
+      , valid{ std::exchange(other.valid, false) }
+    {
+    }
+
+    DBCTable& operator=(DBCTable&& other) noexcept
+    {
+      if (this != &other) {
+        file = std::move(other.file);
+        records = std::exchange(other.records, {});
+        index = std::exchange(other.index, DBCIdIndex{});
+        valid = std::exchange(other.valid, false);
+      }
+
+      return *this;
+    }
+
+    // Main thread only, like the chain's lookups
+    static auto open(MPQChain& chain) -> DBCTable
+    {
+      MPQFile mpq_file = chain.open_file(std::string{ T::FILE_NAME });
+      if (!mpq_file.is_valid()) {
+        spdlog::error("{} isn't in the MPQ chain", T::FILE_NAME);
+        return DBCTable{};
+      }
+
+      return DBCTable{ mpq_file.read_all() };
+    }
+
+    static auto open(const AssetPack& pack) -> DBCTable
+    {
+      const AssetPackEntry* entry = pack.find(T::FILE_NAME);
+      if (!entry) {
+        spdlog::error("{} isn't in the asset pack", T::FILE_NAME);
+        return DBCTable{};
+      }
+
+      return DBCTable{ pack.read(*entry) };
+    }
+
+  public:
+    auto is_valid() const -> bool
+    {
+      return valid;
+    }
+
+    auto size() const -> size_t
+    {
+      return records.size();
+    }
+
+    auto operator[](size_t index) const -> const T&
+    {
+      return records[index];
+    }
+
+    auto get_records() const -> std::span<const T>
+    {
+      return records;
+    }
+
+    // Null when there's no record with the id
+    auto find(u32 id) const -> const T*
+      requires HasDBCId<T>
+    {
+      u32 row = index.find(id);
+      return row != DBCIdIndex::NO_ROW ? &records[row] : nullptr;
+    }
+
+    // Rows by id, for columns that are kept in the table's order (DBCHotColumns)
+    auto get_index() const -> const DBCIdIndex&
+      requires HasDBCId<T>
+    {
+      return index;
+    }
+
+    auto begin() const
+    {
+      return records.begin();
+    }
+
+    auto end() const
+    {
+      return records.end();
+    }
+
+    auto get_string(DBCString string) const -> std::string_view
+    {
+      return file.get_string(string);
+    }
+
+    auto get_string(const DBCLocString& string, DBCLocale locale = DBCLocale::EN_US) const -> std::string_view
+    {
+      return file.get_string(string, locale);
+    }
+
+  private:
+    DBCFile file;
+    std::span<const T> records;
+    DBCIdIndex index;
+    bool valid{ false };
+  };
+
+} // namespace loki
@@ -1,18 +1,191 @@
 #include "mpq_archive.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+#include "engine/time/profiler.h"
 #include "libassert/assert.hpp"
 #include "spdlog/spdlog.h"
 
+namespace {
+
+  // "MPQ\x1A" and "MPQ\x1B"
+  constexpr loki::u32 HEADER_SIGNATURE = 0x1A51'504D;
+  constexpr loki::u32 USER_DATA_SIGNATURE = 0x1B51'504D;
+  constexpr loki::u64 HEADER_ALIGNMENT = 0x200;
+
+  // Anything that keeps the bytes in the archive from being the file's bytes
+  constexpr DWORD NOT_MAPPABLE = MPQ_FILE_COMPRESS_MASK | MPQ_FILE_ENCRYPTED | MPQ_FILE_PATCH_FILE | MPQ_FILE_SECTOR_CRC | MPQ_FILE_DELETE_MARKER;
+
+  auto read_u32(std::span<const std::byte> data, loki::u64 offset) -> loki::u32
+  {
+    loki::u32 value = 0;
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+  }
+
+  // File offsets in the tables are relative to the MPQ header. It sits on a 512 byte boundary, possibly
+  // behind a user data block that points to it.
+  auto find_header(std::span<const std::byte> data) -> std::optional<loki::u64>
+  {
+    for (loki::u64 offset = 0; offset + 16 <= data.size(); offset += HEADER_ALIGNMENT) {
+      loki::u32 signature = read_u32(data, offset);
+      if (signature == HEADER_SIGNATURE) {
+        return offset;
+      }
+
+      if (signature == USER_DATA_SIGNATURE) {
+        loki::u64 header = offset + read_u32(data, offset + 8);
+        if (header + 4 <= data.size() && read_u32(data, header) == HEADER_SIGNATURE) {
+          return header;
+        }
+      }
+    }
+
+    return std::nullopt;
+  }
+
+} // namespace
+
 loki::MPQArchive::MPQArchive(const std::filesystem::path& path)
+  : owned_buffer_pool{ std::make_unique<BufferPool>(BUFFER_POOL_SIZE) }
+  , buffer_pool{ owned_buffer_pool.get() }
 {
-  if (!SFileOpenArchive(path.string().c_str(), 0, 0x00000100 /* Read-only */, &handle)) {
-    spdlog::error("Error opening MPQ archive: {}", path.string());
+  open(path);
+}
+
+loki::MPQArchive::MPQArchive(const std::filesystem::path& path, loki::BufferPool& shared_buffer_pool)
+  : buffer_pool{ &shared_buffer_pool }
+{
+  open(path);
+}
+
+loki::MPQArchive::MPQArchive(loki::MPQArchive&& other) noexcept
+  : handle{ std::exchange(other.handle, HANDLE{}) }
+  , parts{ std::move(other.parts) }
+  , owned_buffer_pool{ std::move(other.owned_buffer_pool) }
+  , buffer_pool{ std::exchange(other.buffer_pool, nullptr) }
+{
+}
+
+loki::MPQArchive&
+loki::MPQArchive::operator=(loki::MPQArchive&& other) noexcept
+{
+  if (this != &other) {
+    close();
+    handle = std::exchange(other.handle, HANDLE{});
+    parts = std::move(other.parts);
+    owned_buffer_pool = std::move(other.owned_buffer_pool);
+    buffer_pool = std::exchange(other.buffer_pool, nullptr);
   }
+
+  return *this;
+}
+
+loki::MPQArchive::~MPQArchive()
+{
+  close();
 }
 
 bool
 loki::MPQArchive::patch(const std::filesystem::path& path, const std::string& prefix)
 {
+  LOKI_PROFILE_ZONE("Patch MPQ archive");
   DEBUG_ASSERT(is_valid(), "Cannot apply a patch to an invalid MPQ archive", this);
-  return SFileOpenPatchArchive(handle, path.string().c_str(), prefix.c_str(), 0);
+  if (!SFileOpenPatchArchive(handle, path.string().c_str(), prefix.c_str(), 0)) {
+    return false;
+  }
+
+  parts.push_back({ path });
+  return true;
+}
+
+auto
+loki::MPQArchive::has_file(const std::string& path) const -> bool
+{
+  return is_valid() && SFileHasFile(handle, path.c_str());
+}
+
+auto
+loki::MPQArchive::open_file(const std::string& path) -> loki::MPQFile
+{
+  HANDLE file{};
+  if (!is_valid() || !SFileOpenFileEx(handle, path.c_str(), SFILE_OPEN_FROM_MPQ, &file)) {
+    return MPQFile{};
+  }
+
+  DWORD high = 0;
+  DWORD low = SFileGetFileSize(file, &high);
+  u64 size = (static_cast<u64>(high) << 32) | low;
+
+  return MPQFile{ file, size, find_mapped_data(file, size), *buffer_pool };
+}
+
+void
+loki::MPQArchive::open(const std::filesystem::path& path)
+{
+  LOKI_PROFILE_ZONE("Open MPQ archive");
+  if (!SFileOpenArchive(path.string().c_str(), 0, 0x00000100 /* Read-only */, &handle)) {
+    spdlog::error("Error opening MPQ archive: {}", path.string());
+    return;
+  }
+
+  parts.push_back({ path });
+}
+
+auto
+loki::MPQArchive::find_mapped_data(HANDLE file, loki::u64 size) -> std::span<const std::byte>
+{
+  DWORD flags = 0;
+  if (size == 0 || !SFileGetFileInfo(file, SFileInfoFlags, &flags, sizeof(flags), nullptr) || (flags & NOT_MAPPABLE) != 0) {
+    return {};
+  }
+
+  // The archives that have the file, StormLib puts it together itself when there is more than one. A list
+  // of strings, each null-terminated, with an empty one at the end.
+  std::array<char, 0x1000> chain{};
+  if (!SFileGetFileInfo(file, SFileInfoPatchChain, chain.data(), static_cast<DWORD>(chain.size() - 2), nullptr)) {
+    return {};
+  }
+
+  std::string_view name{ chain.data() };
+  if (name.empty() || chain[name.size() + 1] != '\0') {
+    return {};
+  }
+
+  auto part = std::find_if(parts.begin(), parts.end(), [name](const Part& part) {
+    return part.path.string() == name;
+  });
+
+  ULONGLONG byte_offset = 0;
+  if (part == parts.end() || !SFileGetFileInfo(file, SFileInfoByteOffset, &byte_offset, sizeof(byte_offset), nullptr)) {
+    return {};
+  }
+
+  if (!part->mapped) {
+    LOKI_PROFILE_ZONE("Map MPQ archive");
+    part->mapped = true;
+    part->mapping = MappedFile{ part->path };
+    part->header_offset = find_header(part->mapping.get_span());
+  }
+
+  auto data = part->mapping.get_span();
+  if (!part->header_offset || *part->header_offset + byte_offset + size > data.size()) {
+    return {};
+  }
+
+  return data.subspan(*part->header_offset + byte_offset, size);
+}
+
+void
+loki::MPQArchive::close()
+{
+  // The patches go with it
+  if (is_valid()) {
+    SFileCloseArchive(handle);
+    handle = HANDLE{};
+  }
 }
@@ -3,14 +3,32 @@
 #include "StormLib.h"
 
 #include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "engine/memory/buffer_pool.h"
+#include "engine/utils/mapped_file.h"
+#include "mpq_file.h"
 
 namespace loki {
 
   class MPQArchive
   {
+  public:
+    // Decompressed files that have been let go of, kept for the next reads
+    static constexpr size_t BUFFER_POOL_SIZE = 0x400'0000;
+
   public:
     explicit MPQArchive() = default;
     explicit MPQArchive(const std::filesystem::path& path);
+    // Reads into a pool other archives share, which has to outlive the archive's files
+    explicit MPQArchive(const std::filesystem::path& path, BufferPool& shared_buffer_pool);
+    MPQArchive(MPQArchive&& other) noexcept;
+    MPQArchive& operator=(MPQArchive&& other) noexcept;
+    ~MPQArchive();
 
   public:
     auto is_valid() const -> bool
@@ -20,9 +38,36 @@ namespace loki {
 
     auto patch(const std::filesystem::path& path, const std::string& prefix = "") -> bool;
 
+    // For StormLib calls that aren't wrapped here
+    auto get_handle() const -> HANDLE
+    {
+      return handle;
+    }
+
+    auto has_file(const std::string& path) const -> bool;
+    // Invalid when neither the archive nor its patches have the file
+    auto open_file(const std::string& path) -> MPQFile;
+
+  private:
+    // The archive or one of its patches, mapped the first time a file in it can be read without a copy
+    struct Part
+    {
+      std::filesystem::path path;
+      MappedFile mapping{};
+      std::optional<u64> header_offset;
+      bool mapped{ false };
+    };
+
+  private:
+    void open(const std::filesystem::path& path);
+    auto find_mapped_data(HANDLE file, u64 size) -> std::span<const std::byte>;
+    void close();
+
   private:
     HANDLE handle{};
+    std::vector<Part> parts;
+    std::unique_ptr<BufferPool> owned_buffer_pool;
+    BufferPool* buffer_pool{ nullptr };
   };
 
 } // namespace loki
-
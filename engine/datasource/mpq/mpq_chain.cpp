@@ -1,32 +1,229 @@
 #include "mpq_chain.h"
 
+#include <algorithm>
+#include <set>
+
+#include "engine/time/profiler.h"
 #include "glob/glob.h"
 #include "spdlog/spdlog.h"
 
-loki::MPQChain::MPQChain(const std::filesystem::path& data_dir)
+namespace {
+
+  struct ChainPattern
+  {
+    const char* pattern;
+    bool deferred;
+  };
+
+  // Lowest precedence first, the order the client loads them in
+  constexpr ChainPattern PATTERNS[] = {
+    { "common.MPQ", false },
+    { "common-2.MPQ", false },
+    { "expansion.MPQ", false },
+    { "lichking.MPQ", false },
+    { "*/locale-*.MPQ", false },
+    { "*/speech-*.MPQ", true },
+    { "*/expansion-locale-*.MPQ", false },
+    { "*/lichking-locale-*.MPQ", false },
+    { "*/expansion-speech-*.MPQ", true },
+    { "*/lichking-speech-*.MPQ", true },
+    { "*/patch-????.MPQ", false },
+    { "*/patch-*.MPQ", false },
+    { "patch.MPQ", false },
+    { "patch-*.MPQ", false },
+  };
+
+  auto get_ms_since(std::chrono::steady_clock::time_point start) -> double
+  {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+} // namespace
+
+loki::MPQChain::MPQChain(const std::filesystem::path& data_dir, const std::filesystem::path& index_path)
+  : start{ std::chrono::steady_clock::now() }
+  , index_path{ index_path }
 {
-  namespace fs = std::filesystem;
+  LOKI_PROFILE_ZONE("Load MPQ chain");
+
+  // The precedence order in one pass: pattern by pattern, names sorted within one so patch-3 beats patch-2.
+  // A file matched by two patterns keeps its first place.
+  std::set<std::filesystem::path> seen;
+  for (const auto& pattern : PATTERNS) {
+    auto paths = glob::glob((data_dir / pattern.pattern).string());
+    std::sort(paths.begin(), paths.end());
 
-  static std::vector<std::string> patterns = { "common.MPQ", "common-2.MPQ", "expansion.MPQ", "lichking.MPQ", "*/locale-*.MPQ", "*/speech-*.MPQ", "*/expansion-locale-*.MPQ",
-    "*/lichking-locale-*.MPQ", "*/expansion-speech-*.MPQ", "*/lichking-speech-*.MPQ", "*/patch-????.MPQ", "*/patch-*.MPQ", "patch.MPQ", "patch-*.MPQ" };
+    for (auto& path : paths) {
+      if (!seen.insert(path).second) {
+        continue;
+      }
 
-  std::vector<std::string> full_patterns;
-  for (const auto& path : patterns) {
-    auto full_path = data_dir / path;
-    full_patterns.push_back(full_path.string());
+      spdlog::info("Found a MPQ file: {}", path.filename().string());
+      auto slot = std::make_unique<Slot>();
+      slot->path = std::move(path);
+      slot->deferred = pattern.deferred;
+      slots.push_back(std::move(slot));
+    }
   }
 
-  for (const auto& path : glob::glob(full_patterns)) {
-    spdlog::info("Found a MPQ file: {}", path.filename().string());
+  std::reverse(slots.begin(), slots.end());
+  readers = std::make_unique<MPQReaderPool>(*this);
+  deferred_remaining = static_cast<u32>(std::count_if(slots.begin(), slots.end(), [](const auto& slot) {
+    return slot->deferred;
+  }));
+
+  // With only the main thread's deque nothing would take the deferred jobs and the index build until it
+  // waits for them, which may be at exit, so those open everything here
+  bool use_jobs = JobSystem::is_initialized() && JobSystem::get_worker_count() > 1;
+
+  // Deferred archives first: the main thread helps from the newest end of its deque, thieves take the oldest
+  for (bool deferred_pass : { true, false }) {
+    for (auto& slot : slots) {
+      if (slot->deferred != deferred_pass) {
+        continue;
+      }
 
-    if (archive.is_valid()) {
-      if (!archive.patch(path)) {
-        spdlog::error("Error patching: {}", path.filename().string());
+      if (!use_jobs) {
+        open(*slot);
+        continue;
       }
-    } else {
-      archive = MPQArchive{ path };
+
+      JobSystem::run(
+          [this, slot = slot.get()]() {
+            open(*slot);
+          },
+          slot->deferred ? &deferred : &essential);
+    }
+  }
+
+  // Cheap next to opening the archives: a stat per archive, and a mapping when the cache is good
+  std::vector<std::filesystem::path> archives;
+  for (const auto& slot : slots) {
+    archives.push_back(slot->path);
+  }
+
+  stamps = MPQIndex::get_stamps(data_dir, archives);
+  if (!index_path.empty()) {
+    index = MPQIndex::load(index_path, stamps);
+  }
+
+  if (index) {
+    index_ready.store(true, std::memory_order_release);
+    spdlog::info("MPQ index: {} files, loaded from the cache", index->get_file_count());
+  } else if (use_jobs) {
+    // Only after the essential archives, the main thread would otherwise pick it up while it waits for them
+    JobSystem::run_after(
+        essential,
+        [this]() {
+          build_index();
+        },
+        &indexing);
+  } else {
+    build_index();
+  }
+
+  // Helping, so the main thread opens archives too
+  JobSystem::wait(essential);
+  spdlog::info("MPQ chain: {} archives, ready in {:.2f} ms", slots.size(), get_ms_since(start));
+}
+
+loki::MPQChain::~MPQChain()
+{
+  // The jobs still opening archives or building the index point into the chain
+  wait_until_loaded();
+}
+
+auto
+loki::MPQChain::has_file(const std::string& path) const -> bool
+{
+  // Names no listfile has aren't indexed, those are still looked for in the archives
+  if (const MPQIndex* file_index = get_index()) {
+    if (const MPQIndexEntry* entry = file_index->find(path)) {
+      return !entry->is_deleted();
+    }
+  }
+
+  return std::any_of(slots.begin(), slots.end(), [&path](const auto& slot) {
+    return slot->ready.load(std::memory_order_acquire) && slot->archive.has_file(path);
+  });
+}
+
+auto
+loki::MPQChain::open_file(const std::string& path) -> loki::MPQFile
+{
+  if (const MPQIndex* file_index = get_index()) {
+    if (const MPQIndexEntry* entry = file_index->find(path)) {
+      return entry->is_deleted() ? MPQFile{} : get_ready_archive(entry->archive).open_file(path);
+    }
+  }
+
+  for (auto& slot : slots) {
+    if (!slot->ready.load(std::memory_order_acquire)) {
+      continue;
+    }
+
+    MPQFile file = slot->archive.open_file(path);
+    if (file.is_valid()) {
+      return file;
     }
   }
 
-  spdlog::info("MPQ chain loading done!");
+  return MPQFile{};
+}
+
+void
+loki::MPQChain::wait_until_loaded()
+{
+  JobSystem::wait(deferred);
+  JobSystem::wait(indexing);
+}
+
+auto
+loki::MPQChain::get_archive(size_t index) -> loki::MPQArchive*
+{
+  Slot& slot = *slots[index];
+  return slot.ready.load(std::memory_order_acquire) ? &slot.archive : nullptr;
+}
+
+auto
+loki::MPQChain::get_ready_archive(loki::u16 index) -> loki::MPQArchive&
+{
+  Slot& slot = *slots[index];
+  if (!slot.ready.load(std::memory_order_acquire)) {
+    // Only ever a speech archive, the index knows it has the file, so it's worth the wait
+    JobSystem::wait(deferred);
+  }
+
+  return slot.archive;
+}
+
+void
+loki::MPQChain::open(loki::MPQChain::Slot& slot)
+{
+  slot.archive = MPQArchive{ slot.path };
+  slot.ready.store(true, std::memory_order_release);
+
+  if (slot.deferred && deferred_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    spdlog::info("MPQ chain: deferred archives attached after {:.2f} ms", get_ms_since(start));
+  }
+}
+
+void
+loki::MPQChain::build_index()
+{
+  std::vector<std::filesystem::path> archives;
+  for (const auto& slot : slots) {
+    archives.push_back(slot->path);
+  }
+
+  auto build_start = std::chrono::steady_clock::now();
+  auto built = MPQIndex::build(archives);
+  spdlog::info("MPQ index: {} files, built in {:.2f} ms", built->get_file_count(), get_ms_since(build_start));
+
+  if (!index_path.empty()) {
+    built->save(index_path, stamps);
+  }
+
+  index = std::move(built);
+  index_ready.store(true, std::memory_order_release);
 }
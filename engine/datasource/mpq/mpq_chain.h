@@ -1,21 +1,107 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "engine/jobs/job_system.h"
 #include "mpq_archive.h"
+#include "mpq_index.h"
+#include "mpq_reader_pool.h"
 
 namespace loki {
 
+  // The archives of a client Data directory, searched from the newest patch down to common.MPQ, the
+  // first one that has a file wins. They are opened in parallel on the job system. The constructor only
+  // waits for the ones the game can't start without, speech archives keep attaching in the background
+  // and lookups skip them until they are open. With one worker or no job system, nothing would pick that up
+  // in the background, so the constructor opens all of them and builds the index itself.
+  //
+  // Once the MPQIndex is there, a lookup is one probe instead of a walk through the archives. It's mapped
+  // from index_path when the archives haven't changed since it was saved, otherwise built in the
+  // background (and saved, given a path) while lookups still walk. Names no listfile has aren't in it,
+  // lookups of those walk the archives as before.
+  //
+  // Lookups are main thread only (StormLib handles aren't thread-safe), opening runs on any worker. Other
+  // threads read through get_readers(), with handles of their own.
   class MPQChain
   {
   public:
     explicit MPQChain() = default;
-    explicit MPQChain(const std::filesystem::path& data_dir);
+    explicit MPQChain(const std::filesystem::path& data_dir, const std::filesystem::path& index_path = {});
+    MPQChain(const MPQChain&) = delete;
+    MPQChain& operator=(const MPQChain&) = delete;
+    ~MPQChain();
+
+  public:
+    auto has_file(const std::string& path) const -> bool;
+    // Invalid when no archive of the chain has the file
+    auto open_file(const std::string& path) -> MPQFile;
+
+    // The deferred archives and the index too
+    auto is_loaded() const -> bool
+    {
+      return deferred.is_done() && indexing.is_done();
+    }
+
+    void wait_until_loaded();
+
+    auto get_archive_count() const -> size_t
+    {
+      return slots.size();
+    }
+
+    // In precedence order, null until it is open
+    auto get_archive(size_t index) -> MPQArchive*;
+
+    auto get_archive_path(size_t index) const -> const std::filesystem::path&
+    {
+      return slots[index]->path;
+    }
+
+    // Null until it's loaded or built
+    auto get_index() const -> const MPQIndex*
+    {
+      return index_ready.load(std::memory_order_acquire) ? index.get() : nullptr;
+    }
+
+    // For asset decoders on the workers, thread-safe
+    auto get_readers() -> MPQReaderPool&
+    {
+      return *readers;
+    }
+
+  private:
+    struct Slot
+    {
+      std::filesystem::path path;
+      // Not waited for by the constructor
+      bool deferred{ false };
+      std::atomic<bool> ready{ false };
+      MPQArchive archive;
+    };
 
   private:
-    MPQArchive archive;
+    void open(Slot& slot);
+    void build_index();
+    // Waits for the slot when it's a deferred archive still opening
+    auto get_ready_archive(u16 index) -> MPQArchive&;
+
+  private:
+    std::vector<std::unique_ptr<Slot>> slots;
+    JobCounter essential;
+    JobCounter deferred;
+    std::atomic<u32> deferred_remaining{ 0 };
+    std::chrono::steady_clock::time_point start;
+    std::filesystem::path index_path;
+    std::vector<MPQArchiveStamp> stamps;
+    std::unique_ptr<MPQIndex> index;
+    std::atomic<bool> index_ready{ false };
+    JobCounter indexing;
+    std::unique_ptr<MPQReaderPool> readers;
   };
 
 } // namespace loki
-
@@ -1 +1,114 @@
 #include "mpq_file.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "engine/time/profiler.h"
+#include "spdlog/spdlog.h"
+
+loki::MPQFileData::MPQFileData(loki::MPQFileData&& other) noexcept
+  : buffer{ std::move(other.buffer) }
+  , view{ std::exchange(other.view, {}) }
+{
+}
+
+loki::MPQFileData&
+loki::MPQFileData::operator=(loki::MPQFileData&& other) noexcept
+{
+  if (this != &other) {
+    buffer = std::move(other.buffer);
+    view = std::exchange(other.view, {});
+  }
+
+  return *this;
+}
+
+loki::MPQFile::MPQFile(loki::MPQFile&& other) noexcept
+  : handle{ std::exchange(other.handle, HANDLE{}) }
+  , size{ std::exchange(other.size, 0) }
+  , position{ std::exchange(other.position, 0) }
+  , mapped{ std::exchange(other.mapped, {}) }
+  , buffer_pool{ std::exchange(other.buffer_pool, nullptr) }
+{
+}
+
+loki::MPQFile&
+loki::MPQFile::operator=(loki::MPQFile&& other) noexcept
+{
+  if (this != &other) {
+    close();
+    handle = std::exchange(other.handle, HANDLE{});
+    size = std::exchange(other.size, 0);
+    position = std::exchange(other.position, 0);
+    mapped = std::exchange(other.mapped, {});
+    buffer_pool = std::exchange(other.buffer_pool, nullptr);
+  }
+
+  return *this;
+}
+
+loki::MPQFile::~MPQFile()
+{
+  close();
+}
+
+auto
+loki::MPQFile::read(loki::u64 offset, std::span<std::byte> destination) -> size_t
+{
+  if (offset >= size) {
+    return 0;
+  }
+
+  size_t count = static_cast<size_t>(std::min<u64>(destination.size(), size - offset));
+  if (!mapped.empty()) {
+    std::memcpy(destination.data(), mapped.data() + offset, count);
+    return count;
+  }
+
+  LONG high = static_cast<LONG>(offset >> 32);
+  SFileSetFilePointer(handle, static_cast<LONG>(offset & 0xFFFF'FFFF), &high, FILE_BEGIN);
+
+  DWORD read = 0;
+  SFileReadFile(handle, destination.data(), static_cast<DWORD>(count), &read, nullptr);
+  if (read != count) {
+    spdlog::error("Short MPQ file read: {} of {} bytes at {}", read, count, offset);
+  }
+
+  return read;
+}
+
+auto
+loki::MPQFile::read_all() -> loki::MPQFileData
+{
+  if (!mapped.empty() || size == 0) {
+    return MPQFileData{ mapped };
+  }
+
+  LOKI_PROFILE_ZONE("Decompress MPQ file");
+  PooledBuffer buffer = buffer_pool->acquire(static_cast<size_t>(size));
+  read(0, buffer.get_span());
+  return MPQFileData{ std::move(buffer) };
+}
+
+auto
+loki::MPQFile::read_next(std::span<std::byte> destination) -> size_t
+{
+  size_t count = read(position, destination);
+  position += count;
+  return count;
+}
+
+void
+loki::MPQFile::seek(loki::u64 offset)
+{
+  position = std::min(offset, size);
+}
+
+void
+loki::MPQFile::close()
+{
+  if (is_valid()) {
+    SFileCloseFile(handle);
+    handle = HANDLE{};
+  }
+}
@@ -1,18 +1,129 @@
 #pragma once
 
-#include "mpq_archive.h"
+#include "StormLib.h"
+
+#include <cstddef>
+#include <span>
+#include <utility>
+
+#include "engine/memory/buffer_pool.h"
+#include "engine/utils/types.h"
 
 namespace loki {
 
+  // A whole file: a view into the mapped archive when the file is stored as it is, otherwise a pooled
+  // buffer it was decompressed into. Only valid while the archive it came from is alive.
+  class MPQFileData
+  {
+  public:
+    explicit MPQFileData() = default;
+
+    explicit MPQFileData(std::span<const std::byte> view)
+      : view{ view }
+    {
+    }
+
+    explicit MPQFileData(PooledBuffer&& pooled)
+      : buffer{ std::move(pooled) }
+      , view{ buffer.get_span() }
+    {
+    }
+
+    // The other one is empty after, its view would point into the buffer this one has now
+    MPQFileData(MPQFileData&& other) noexcept;
+    MPQFileData& operator=(MPQFileData&& other) noexcept;
+
+  public:
+    auto get_span() const -> std::span<const std::byte>
+    {
+      return view;
+    }
+
+    // No copy was made
+    auto is_mapped() const -> bool
+    {
+      return buffer.get_capacity() == 0;
+    }
+
+    // Of the buffer it was decompressed into, 0 when it's mapped
+    auto get_allocated_size() const -> size_t
+    {
+      return buffer.get_capacity();
+    }
+
+    // Frees the buffer rather than pooling it again, the data is empty after
+    void discard()
+    {
+      buffer.discard();
+      view = {};
+    }
+
+  private:
+    PooledBuffer buffer;
+    std::span<const std::byte> view;
+  };
+
+  // A file of an archive and its patches. Files stored uncompressed, unencrypted and unpatched are read
+  // straight from the mapped archive, everything else goes through StormLib, which only decompresses the
+  // sectors a read touches. Not thread-safe, and it can't outlive its archive.
   class MPQFile
   {
   public:
-    explicit MPQFile(MPQArchive& archive)
-      : archive{ archive } {};
+    explicit MPQFile() = default;
+    MPQFile(MPQFile&& other) noexcept;
+    MPQFile& operator=(MPQFile&& other) noexcept;
+    ~MPQFile();
+
+  public:
+    auto is_valid() const -> bool
+    {
+      return handle != HANDLE{};
+    }
+
+    auto get_size() const -> u64
+    {
+      return size;
+    }
+
+    // The file in the mapped archive, empty when it can't be read without decompressing it
+    auto get_mapped_span() const -> std::span<const std::byte>
+    {
+      return mapped;
+    }
+
+    // Up to destination.size() bytes from offset on, fewer at the end of the file. Returns how many were read.
+    auto read(u64 offset, std::span<std::byte> destination) -> size_t;
+    // Without a copy when the file is mapped
+    auto read_all() -> MPQFileData;
+
+    // Streaming, from the current position on
+    auto read_next(std::span<std::byte> destination) -> size_t;
+    void seek(u64 offset);
+
+    auto get_position() const -> u64
+    {
+      return position;
+    }
 
   private:
-    MPQArchive& archive;
+    friend class MPQArchive;
+
+    MPQFile(HANDLE handle, u64 size, std::span<const std::byte> mapped, BufferPool& buffer_pool)
+      : handle{ handle }
+      , size{ size }
+      , mapped{ mapped }
+      , buffer_pool{ &buffer_pool }
+    {
+    }
+
+    void close();
+
+  private:
+    HANDLE handle{};
+    u64 size{ 0 };
+    u64 position{ 0 };
+    std::span<const std::byte> mapped;
+    BufferPool* buffer_pool{ nullptr };
   };
 
 } // namespace loki
-
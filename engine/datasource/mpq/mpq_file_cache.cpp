@@ -0,0 +1,183 @@
+#include "mpq_file_cache.h"
+
+#include "engine/datasource/pack/asset_pack.h"
+#include "engine/time/profiler.h"
+#include "libassert/assert.hpp"
+#include "mpq_chain.h"
+
+loki::CachedMPQFile::CachedMPQFile(loki::CachedMPQFile&& other) noexcept
+  : pins{ std::exchange(other.pins, nullptr) }
+  , data{ std::exchange(other.data, {}) }
+{
+}
+
+loki::CachedMPQFile&
+loki::CachedMPQFile::operator=(loki::CachedMPQFile&& other) noexcept
+{
+  if (this != &other) {
+    release();
+    pins = std::exchange(other.pins, nullptr);
+    data = std::exchange(other.data, {});
+  }
+
+  return *this;
+}
+
+loki::CachedMPQFile::~CachedMPQFile()
+{
+  release();
+}
+
+void
+loki::CachedMPQFile::release()
+{
+  // The entry may be evicted right after, it isn't touched again
+  if (pins) {
+    pins->fetch_sub(1, std::memory_order_release);
+    pins = nullptr;
+    data = {};
+  }
+}
+
+loki::MPQFileCache::MPQFileCache(loki::MPQChain& chain, size_t budget_bytes)
+  : chain{ &chain }
+  , budget{ budget_bytes }
+{
+}
+
+loki::MPQFileCache::MPQFileCache(const loki::AssetPack& pack, size_t budget_bytes)
+  : pack{ &pack }
+  , budget{ budget_bytes }
+{
+}
+
+loki::MPQFileCache::~MPQFileCache()
+{
+  for (auto& shard : shards) {
+    for (const auto& entry : shard.entries) {
+      DEBUG_ASSERT(entry.pins.load(std::memory_order_acquire) == 0, "A cached MPQ file outlived the cache");
+    }
+  }
+}
+
+auto
+loki::MPQFileCache::get(const std::string& path) -> loki::CachedMPQFile
+{
+  u64 hash = MPQIndex::hash_path(path);
+  Shard& shard = shards[hash % SHARD_COUNT];
+
+  {
+    std::scoped_lock lock{ shard.mutex };
+    if (auto it = shard.lookup.find(hash); it != shard.lookup.end()) {
+      shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+      shard.hits++;
+
+      Entry& entry = *it->second;
+      entry.pins.fetch_add(1, std::memory_order_relaxed);
+      return CachedMPQFile{ &entry.pins, entry.data.get_span() };
+    }
+
+    shard.misses++;
+  }
+
+  // Unlocked, the shard's other files stay available meanwhile
+  MPQFileData data;
+  if (pack) {
+    LOKI_PROFILE_ZONE("Read packed file into the cache");
+    const AssetPackEntry* entry = pack->find(path);
+    if (!entry) {
+      return CachedMPQFile{};
+    }
+
+    data = pack->read(*entry);
+  } else {
+    LOKI_PROFILE_ZONE("Read MPQ file into the cache");
+    MPQFile file = chain->get_readers().open_file(path);
+    if (!file.is_valid()) {
+      return CachedMPQFile{};
+    }
+
+    data = file.read_all();
+  }
+
+  std::scoped_lock lock{ shard.mutex };
+  auto [it, inserted] = shard.lookup.try_emplace(hash);
+  if (inserted) {
+    Entry& entry = shard.entries.emplace_front();
+    entry.hash = hash;
+    entry.data = std::move(data);
+    entry.charge = entry.data.get_allocated_size() + ENTRY_OVERHEAD;
+    it->second = shard.entries.begin();
+    shard.bytes += entry.charge;
+  } else {
+    // Read by another thread in the meantime, this copy goes
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+  }
+
+  // Pinned before evicting, so a file bigger than the shard's share at least makes it back to the caller
+  Entry& entry = *it->second;
+  entry.pins.fetch_add(1, std::memory_order_relaxed);
+  evict(shard);
+  return CachedMPQFile{ &entry.pins, entry.data.get_span() };
+}
+
+void
+loki::MPQFileCache::clear()
+{
+  for (auto& shard : shards) {
+    std::scoped_lock lock{ shard.mutex };
+    for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+      if (it->pins.load(std::memory_order_acquire) != 0) {
+        ++it;
+        continue;
+      }
+
+      shard.lookup.erase(it->hash);
+      shard.bytes -= it->charge;
+      it->data.discard();
+      it = shard.entries.erase(it);
+    }
+  }
+}
+
+auto
+loki::MPQFileCache::get_stats() -> loki::MPQFileCacheStats
+{
+  MPQFileCacheStats stats;
+  for (auto& shard : shards) {
+    std::scoped_lock lock{ shard.mutex };
+    stats.hits += shard.hits;
+    stats.misses += shard.misses;
+    stats.evictions += shard.evictions;
+    stats.entries += shard.entries.size();
+    stats.bytes += shard.bytes;
+
+    for (const auto& entry : shard.entries) {
+      stats.pinned_entries += entry.pins.load(std::memory_order_relaxed) != 0;
+    }
+  }
+
+  return stats;
+}
+
+void
+loki::MPQFileCache::evict(loki::MPQFileCache::Shard& shard)
+{
+  size_t shard_budget = budget / SHARD_COUNT;
+
+  // From the least recently used end, until the shard fits or only pinned files are left
+  auto it = shard.entries.end();
+  while (shard.bytes > shard_budget && it != shard.entries.begin()) {
+    --it;
+    if (it->pins.load(std::memory_order_acquire) != 0) {
+      continue;
+    }
+
+    // Freed, not pooled: a pool keeping it would hold memory the budget no longer counts
+    shard.lookup.erase(it->hash);
+    shard.bytes -= it->charge;
+    shard.evictions++;
+    it->data.discard();
+    it = shard.entries.erase(it);
+  }
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "mpq_file.h"
+
+namespace loki {
+
+  class AssetPack;
+  class MPQChain;
+
+  struct MPQFileCacheStats
+  {
+    u64 hits{ 0 };
+    u64 misses{ 0 };
+    u64 evictions{ 0 };
+    u64 entries{ 0 };
+    // Charged against the budget, the files' buffers and a bit for every entry
+    u64 bytes{ 0 };
+    // Held by a CachedMPQFile right now, never evicted
+    u64 pinned_entries{ 0 };
+  };
+
+  class MPQFileCache;
+
+  // A whole file out of the cache, pinned there until this is destroyed. Can be moved to another thread,
+  // and can't outlive the cache.
+  class CachedMPQFile
+  {
+  public:
+    explicit CachedMPQFile() = default;
+    CachedMPQFile(CachedMPQFile&& other) noexcept;
+    CachedMPQFile& operator=(CachedMPQFile&& other) noexcept;
+    ~CachedMPQFile();
+
+  public:
+    void release();
+
+    auto is_valid() const -> bool
+    {
+      return pins != nullptr;
+    }
+
+    auto get_span() const -> std::span<const std::byte>
+    {
+      return data;
+    }
+
+  private:
+    friend class MPQFileCache;
+
+    CachedMPQFile(std::atomic<u32>* pins, std::span<const std::byte> data)
+      : pins{ pins }
+      , data{ data }
+    {
+    }
+
+  private:
+    std::atomic<u32>* pins{ nullptr };
+    std::span<const std::byte> data;
+  };
+
+  // Decompressed files of a chain by path, for what is asked for again and again: shared textures, DBCs,
+  // doodad models. Split into shards by the path's hash, each with a lock and an LRU list of its own, so
+  // the asset workers rarely wait for each other. Misses read through the chain's reader pool, or from
+  // the asset pack mounted instead of it.
+  //
+  // A shard evicts its least recently used files when it goes over its share of the budget, skipping the
+  // pinned ones, so while enough is pinned it stays over. Evicted buffers are freed rather than handed
+  // back to the reader's BufferPool, so the budget bounds what the cache holds on to. Two threads that
+  // miss the same file at once both read it, the second one to get back uses the first one's.
+  // Thread-safe.
+  class MPQFileCache
+  {
+  public:
+    static constexpr size_t SHARD_COUNT = 16;
+    // Besides the file, what an entry costs: the nodes, the map's bucket
+    static constexpr size_t ENTRY_OVERHEAD = 0x80;
+
+  public:
+    explicit MPQFileCache(MPQChain& chain, size_t budget_bytes);
+    explicit MPQFileCache(const AssetPack& pack, size_t budget_bytes);
+    MPQFileCache(const MPQFileCache&) = delete;
+    MPQFileCache& operator=(const MPQFileCache&) = delete;
+    ~MPQFileCache();
+
+  public:
+    // Invalid when the chain doesn't have the file
+    auto get(const std::string& path) -> CachedMPQFile;
+    // Everything that isn't pinned
+    void clear();
+
+    auto get_budget() const -> size_t
+    {
+      return budget;
+    }
+
+    // Added up shard by shard, they may be a few reads apart
+    auto get_stats() -> MPQFileCacheStats;
+
+  private:
+    struct Entry
+    {
+      u64 hash;
+      MPQFileData data;
+      size_t charge;
+      std::atomic<u32> pins{ 0 };
+    };
+
+    // Apart, shards locked by different threads don't share a cache line
+    struct alignas(64) Shard
+    {
+      std::mutex mutex;
+      // Most recently used first
+      std::list<Entry> entries;
+      std::unordered_map<u64, std::list<Entry>::iterator> lookup;
+      size_t bytes{ 0 };
+      u64 hits{ 0 };
+      u64 misses{ 0 };
+      u64 evictions{ 0 };
+    };
+
+  private:
+    // With the shard locked
+    void evict(Shard& shard);
+
+  private:
+    // One or the other
+    MPQChain* chain{ nullptr };
+    const AssetPack* pack{ nullptr };
+    size_t budget;
+    std::array<Shard, SHARD_COUNT> shards;
+  };
+
+} // namespace loki
@@ -0,0 +1,260 @@
+#include "mpq_index.h"
+
+#include "StormLib.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "engine/jobs/job_system.h"
+#include "engine/time/profiler.h"
+#include "engine/utils/string_hash.h"
+#include "mpq_archive.h"
+#include "spdlog/spdlog.h"
+
+namespace {
+
+  constexpr loki::u32 CACHE_MAGIC = 0x49'4D'4B'4C; // "LKMI"
+  constexpr loki::u32 CACHE_VERSION = 2;
+  // Longer paths are hashed from a copy
+  constexpr size_t MAX_PATH_LENGTH = 0x200;
+
+  // Followed by the archive stamps, then the slots, all of it mapped as is on the next start
+  struct CacheHeader
+  {
+    loki::u32 magic{ CACHE_MAGIC };
+    loki::u32 version{ CACHE_VERSION };
+    loki::u32 archive_count{ 0 };
+    loki::u32 file_count{ 0 };
+    loki::u64 slot_count{ 0 };
+  };
+
+  static_assert(sizeof(CacheHeader) % alignof(loki::MPQIndexEntry) == 0);
+  static_assert(sizeof(loki::MPQArchiveStamp) % alignof(loki::MPQIndexEntry) == 0);
+  static_assert(sizeof(loki::MPQIndexEntry) == 16, "The cache format depends on the entry layout, bump CACHE_VERSION");
+
+  auto normalise(char ch) -> char
+  {
+    if (ch == '/') {
+      return '\\';
+    }
+
+    return ch >= 'a' && ch <= 'z' ? static_cast<char>(ch - 'a' + 'A') : ch;
+  }
+
+  // Every file the archive's listfile names, through a handle of its own
+  auto read_archive(const std::filesystem::path& path, loki::u16 archive_index) -> std::vector<loki::MPQIndexEntry>
+  {
+    LOKI_PROFILE_ZONE("Index MPQ archive");
+    loki::MPQArchive archive{ path };
+    if (!archive.is_valid()) {
+      return {};
+    }
+
+    std::vector<loki::MPQIndexEntry> entries;
+    SFILE_FIND_DATA data{};
+    HANDLE find = SFileFindFirstFile(archive.get_handle(), "*", &data, nullptr);
+    for (bool found = find != nullptr; found; found = SFileFindNextFile(find, &data)) {
+      loki::MPQIndexEntry entry{};
+      entry.hash = loki::MPQIndex::hash_path(data.cFileName);
+      entry.archive = (data.dwFileFlags & MPQ_FILE_DELETE_MARKER) ? loki::MPQIndexEntry::DELETED : archive_index;
+      entries.push_back(entry);
+    }
+
+    if (find) {
+      SFileFindClose(find);
+    }
+
+    return entries;
+  }
+
+} // namespace
+
+auto
+loki::MPQIndex::hash_path(std::string_view path) -> loki::u64
+{
+  u64 hash = 0;
+  if (path.size() <= MAX_PATH_LENGTH) {
+    std::array<char, MAX_PATH_LENGTH> buffer;
+    std::transform(path.begin(), path.end(), buffer.begin(), normalise);
+    hash = hash_string({ buffer.data(), path.size() });
+  } else {
+    std::string copy{ path };
+    std::transform(copy.begin(), copy.end(), copy.begin(), normalise);
+    hash = hash_string(copy);
+  }
+
+  // 0 marks an empty slot
+  return hash ? hash : 1;
+}
+
+auto
+loki::MPQIndex::get_stamps(const std::filesystem::path& data_dir, const std::vector<std::filesystem::path>& archives) -> std::vector<loki::MPQArchiveStamp>
+{
+  std::vector<MPQArchiveStamp> stamps;
+  for (const auto& path : archives) {
+    std::error_code error;
+    MPQArchiveStamp stamp{};
+    stamp.path_hash = hash_string(path.lexically_relative(data_dir).generic_string());
+    stamp.size = std::filesystem::file_size(path, error);
+    stamp.modified = static_cast<i64>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    stamps.push_back(stamp);
+  }
+
+  return stamps;
+}
+
+auto
+loki::MPQIndex::build(const std::vector<std::filesystem::path>& archives) -> std::unique_ptr<loki::MPQIndex>
+{
+  LOKI_PROFILE_ZONE("Build MPQ index");
+
+  std::vector<std::vector<MPQIndexEntry>> files(archives.size());
+  auto read = [&files, &archives](u32 begin, u32 end) {
+    for (u32 i = begin; i < end; ++i) {
+      files[i] = read_archive(archives[i], static_cast<u16>(i));
+    }
+  };
+
+  if (JobSystem::is_initialized()) {
+    JobCounter counter;
+    JobSystem::parallel_for(static_cast<u32>(archives.size()), 1, read, counter);
+    JobSystem::wait(counter);
+  } else {
+    read(0, static_cast<u32>(archives.size()));
+  }
+
+  size_t total = 0;
+  for (const auto& entries : files) {
+    total += entries.size();
+  }
+
+  // Load factor under 1/2, probe sequences stay short
+  auto index = std::make_unique<MPQIndex>();
+  index->owned_slots.resize(std::bit_ceil(std::max<size_t>(total * 2, 16)));
+  size_t mask = index->owned_slots.size() - 1;
+
+  // Newest archive first, whoever has a name already wins over what comes after
+  for (const auto& entries : files) {
+    for (const auto& entry : entries) {
+      size_t i = entry.hash & mask;
+      while (index->owned_slots[i].hash != 0 && index->owned_slots[i].hash != entry.hash) {
+        i = (i + 1) & mask;
+      }
+
+      if (index->owned_slots[i].hash == 0) {
+        index->owned_slots[i] = entry;
+        index->file_count += !entry.is_deleted();
+      }
+    }
+  }
+
+  index->slots = index->owned_slots;
+  return index;
+}
+
+auto
+loki::MPQIndex::load(const std::filesystem::path& path, const std::vector<loki::MPQArchiveStamp>& stamps) -> std::unique_ptr<loki::MPQIndex>
+{
+  LOKI_PROFILE_ZONE("Load MPQ index");
+
+  std::error_code error;
+  if (!std::filesystem::exists(path, error)) {
+    return nullptr;
+  }
+
+  MappedFile mapping{ path };
+  auto data = mapping.get_span();
+  if (data.size() < sizeof(CacheHeader)) {
+    return nullptr;
+  }
+
+  CacheHeader header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.archive_count != stamps.size() || !std::has_single_bit(header.slot_count)) {
+    return nullptr;
+  }
+
+  size_t slots_offset = sizeof(CacheHeader) + stamps.size() * sizeof(MPQArchiveStamp);
+  if (data.size() != slots_offset + header.slot_count * sizeof(MPQIndexEntry)) {
+    spdlog::warn("Dropping corrupted MPQ index cache {}", path.string());
+    return nullptr;
+  }
+
+  for (size_t i = 0; i < stamps.size(); ++i) {
+    MPQArchiveStamp stamp;
+    std::memcpy(&stamp, data.data() + sizeof(CacheHeader) + i * sizeof(MPQArchiveStamp), sizeof(stamp));
+    if (stamp.path_hash != stamps[i].path_hash || stamp.size != stamps[i].size || stamp.modified != stamps[i].modified) {
+      spdlog::info("MPQ index cache is out of date, the archives changed");
+      return nullptr;
+    }
+  }
+
+  auto index = std::make_unique<MPQIndex>();
+  index->slots = { reinterpret_cast<const MPQIndexEntry*>(data.data() + slots_offset), static_cast<size_t>(header.slot_count) };
+  index->file_count = header.file_count;
+  index->mapping = std::move(mapping);
+  return index;
+}
+
+auto
+loki::MPQIndex::save(const std::filesystem::path& path, const std::vector<loki::MPQArchiveStamp>& stamps) const -> bool
+{
+  LOKI_PROFILE_ZONE("Save MPQ index");
+
+  std::error_code error;
+  std::filesystem::create_directories(path.parent_path(), error);
+
+  CacheHeader header;
+  header.archive_count = static_cast<u32>(stamps.size());
+  header.file_count = static_cast<u32>(file_count);
+  header.slot_count = slots.size();
+
+  // Write to a temporary file first, a crash mid-write must not leave a truncated index behind
+  auto temp_path = path;
+  temp_path += ".tmp";
+
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(stamps.data()), static_cast<std::streamsize>(stamps.size() * sizeof(MPQArchiveStamp)));
+    file.write(reinterpret_cast<const char*>(slots.data()), static_cast<std::streamsize>(slots.size() * sizeof(MPQIndexEntry)));
+    if (!file) {
+      spdlog::warn("Failed to write the MPQ index cache {}", path.string());
+      return false;
+    }
+  }
+
+  std::filesystem::rename(temp_path, path, error);
+  if (error) {
+    spdlog::warn("Failed to store the MPQ index cache {}: {}", path.string(), error.message());
+    std::filesystem::remove(temp_path, error);
+    return false;
+  }
+
+  return true;
+}
+
+auto
+loki::MPQIndex::find(std::string_view path) const -> const loki::MPQIndexEntry*
+{
+  if (slots.empty()) {
+    return nullptr;
+  }
+
+  u64 hash = hash_path(path);
+  size_t mask = slots.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    const MPQIndexEntry& slot = slots[i];
+    if (slot.hash == 0) {
+      return nullptr;
+    }
+
+    if (slot.hash == hash) {
+      return &slot;
+    }
+  }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "engine/utils/mapped_file.h"
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  struct MPQIndexEntry
+  {
+    static constexpr u16 DELETED = 0xFFFF;
+
+    // Of the normalised path, 0 for an empty slot
+    u64 hash;
+    // The winning archive, in the chain's precedence order. DELETED when a patch removed the file.
+    u16 archive;
+    u16 reserved;
+    u32 padding;
+
+    auto is_deleted() const -> bool
+    {
+      return archive == DELETED;
+    }
+  };
+
+  // What the cache was built from, a different size or modification time of any archive rebuilds it
+  struct MPQArchiveStamp
+  {
+    // Of the path relative to the Data directory
+    u64 path_hash;
+    u64 size;
+    i64 modified;
+  };
+
+  // Every named file of a chain by the hash of its normalised path (upper case, backslashes), with the
+  // patch precedence resolved already, so a lookup is a single probe. Built from the archives' listfiles,
+  // or mapped straight from the cache file an earlier run saved.
+  //
+  // A hash table entry that no listfile names can't be indexed, StormLib only has the name's hash for
+  // it. Such files are still in the archives, so a miss here means walking them, not that the file isn't
+  // there.
+  class MPQIndex
+  {
+  public:
+    static auto hash_path(std::string_view path) -> u64;
+    static auto get_stamps(const std::filesystem::path& data_dir, const std::vector<std::filesystem::path>& archives) -> std::vector<MPQArchiveStamp>;
+
+    // Archives in precedence order, the first one wins. Opens handles of its own, so the chain's can be
+    // used meanwhile, and reads the archives in parallel on the job system.
+    static auto build(const std::vector<std::filesystem::path>& archives) -> std::unique_ptr<MPQIndex>;
+    // Null when there is no cache file or it was written for other archives
+    static auto load(const std::filesystem::path& path, const std::vector<MPQArchiveStamp>& stamps) -> std::unique_ptr<MPQIndex>;
+    auto save(const std::filesystem::path& path, const std::vector<MPQArchiveStamp>& stamps) const -> bool;
+
+  public:
+    // Null when no listfile names the file. When the newest archive that had it deleted it, is_deleted().
+    auto find(std::string_view path) const -> const MPQIndexEntry*;
+
+    auto get_file_count() const -> size_t
+    {
+      return file_count;
+    }
+
+  private:
+    std::vector<MPQIndexEntry> owned_slots;
+    MappedFile mapping;
+    std::span<const MPQIndexEntry> slots;
+    size_t file_count{ 0 };
+  };
+
+} // namespace loki
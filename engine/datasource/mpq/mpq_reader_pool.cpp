@@ -0,0 +1,96 @@
+#include "mpq_reader_pool.h"
+
+#include "engine/jobs/job_system.h"
+#include "engine/time/profiler.h"
+#include "mpq_chain.h"
+
+loki::MPQReaderPool::MPQReaderPool(const loki::MPQChain& chain)
+  : chain{ chain }
+  , worker_readers(JobSystem::is_initialized() ? JobSystem::get_worker_count() : 0)
+{
+}
+
+auto
+loki::MPQReaderPool::has_file(const std::string& path) -> bool
+{
+  // The index is immutable once it's there, any thread can probe it. Unnamed files aren't in it.
+  if (const MPQIndex* index = chain.get_index()) {
+    if (const MPQIndexEntry* entry = index->find(path)) {
+      return !entry->is_deleted();
+    }
+  }
+
+  ThreadReader& reader = get_thread_reader();
+  for (size_t i = 0; i < reader.archives.size(); ++i) {
+    if (get_archive(reader, i).has_file(path)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+auto
+loki::MPQReaderPool::open_file(const std::string& path) -> loki::MPQFile
+{
+  ThreadReader& reader = get_thread_reader();
+
+  if (const MPQIndex* index = chain.get_index()) {
+    if (const MPQIndexEntry* entry = index->find(path)) {
+      return entry->is_deleted() ? MPQFile{} : get_archive(reader, entry->archive).open_file(path);
+    }
+  }
+
+  for (size_t i = 0; i < reader.archives.size(); ++i) {
+    MPQFile file = get_archive(reader, i).open_file(path);
+    if (file.is_valid()) {
+      return file;
+    }
+  }
+
+  return MPQFile{};
+}
+
+auto
+loki::MPQReaderPool::get_thread_reader() -> loki::MPQReaderPool::ThreadReader&
+{
+  auto make_reader = [this]() {
+    auto reader = std::make_unique<ThreadReader>();
+    reader->archives.resize(chain.get_archive_count());
+    reader->opened.resize(chain.get_archive_count());
+    thread_count.fetch_add(1, std::memory_order_relaxed);
+    return reader;
+  };
+
+  u32 worker = JobSystem::is_initialized() ? JobSystem::get_worker_index() : JobSystem::NOT_A_WORKER;
+  if (worker < worker_readers.size()) {
+    auto& reader = worker_readers[worker];
+    if (!reader) {
+      reader = make_reader();
+    }
+
+    return *reader;
+  }
+
+  // A thread id can come back once its thread is gone, its handles are as good as new to the next one
+  std::scoped_lock lock{ mutex };
+  auto& reader = thread_readers[std::this_thread::get_id()];
+  if (!reader) {
+    reader = make_reader();
+  }
+
+  return *reader;
+}
+
+auto
+loki::MPQReaderPool::get_archive(loki::MPQReaderPool::ThreadReader& reader, size_t index) -> loki::MPQArchive&
+{
+  // Tried once, an archive that fails to open here failed for the chain too
+  if (!reader.opened[index]) {
+    LOKI_PROFILE_ZONE("Open MPQ archive for a thread");
+    reader.opened[index] = true;
+    reader.archives[index] = MPQArchive{ chain.get_archive_path(index), buffer_pool };
+  }
+
+  return reader.archives[index];
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "mpq_archive.h"
+
+namespace loki {
+
+  class MPQChain;
+
+  // Reads from a chain's archives on any number of threads at once. A StormLib handle can only be used by
+  // one thread at a time, so every thread gets archive handles of its own, opened the first time it needs
+  // one of the archives. Nothing is locked on a read: job workers find their handles by worker index, other
+  // threads through a map that is locked for the lookup only.
+  //
+  // A file stays with the thread that opened it, and can't outlive the pool. Each thread maps the archives
+  // it reads separately, the pages themselves are shared, and all of them read into one BufferPool.
+  class MPQReaderPool
+  {
+  public:
+    // Decompressed files kept for all of the threads and archives together, BufferPool is thread-safe
+    static constexpr size_t BUFFER_POOL_SIZE = 0x400'0000;
+
+  public:
+    // The job system's worker count is taken from here, it has to be initialized already if workers read
+    explicit MPQReaderPool(const MPQChain& chain);
+    MPQReaderPool(const MPQReaderPool&) = delete;
+    MPQReaderPool& operator=(const MPQReaderPool&) = delete;
+
+  public:
+    // The same files as the chain, speech archives included before the chain has them open
+    auto has_file(const std::string& path) -> bool;
+    // Invalid when no archive of the chain has the file
+    auto open_file(const std::string& path) -> MPQFile;
+
+    // Threads that have opened archives of their own so far
+    auto get_thread_count() const -> size_t
+    {
+      return thread_count.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct ThreadReader
+    {
+      // In the chain's precedence order, opened on first use
+      std::vector<MPQArchive> archives;
+      std::vector<bool> opened;
+    };
+
+  private:
+    auto get_thread_reader() -> ThreadReader&;
+    auto get_archive(ThreadReader& reader, size_t index) -> MPQArchive&;
+
+  private:
+    const MPQChain& chain;
+    // Before the handles, so it is destroyed after them
+    BufferPool buffer_pool{ BUFFER_POOL_SIZE };
+    // Indexed by JobSystem::get_worker_index(), each is only touched by its own worker
+    std::vector<std::unique_ptr<ThreadReader>> worker_readers;
+    std::mutex mutex;
+    std::unordered_map<std::thread::id, std::unique_ptr<ThreadReader>> thread_readers;
+    std::atomic<size_t> thread_count{ 0 };
+  };
+
+} // namespace loki
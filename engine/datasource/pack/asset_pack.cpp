@@ -0,0 +1,89 @@
+#include "asset_pack.h"
+
+#include <lz4.h>
+
+#include <cstring>
+
+#include "engine/datasource/mpq/mpq_index.h"
+#include "engine/time/profiler.h"
+#include "engine/utils/perfect_hash.h"
+#include "spdlog/spdlog.h"
+
+namespace {
+
+  auto align_up(loki::u64 value, loki::u64 alignment) -> loki::u64
+  {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+} // namespace
+
+loki::AssetPack::AssetPack(const std::filesystem::path& path)
+  : mapping{ path }
+  , buffer_pool{ std::make_unique<BufferPool>(BUFFER_POOL_SIZE) }
+{
+  LOKI_PROFILE_ZONE("Mount asset pack");
+
+  auto data = mapping.get_span();
+  if (data.size() < sizeof(AssetPackHeader)) {
+    spdlog::error("Error opening asset pack: {}", path.string());
+    return;
+  }
+
+  AssetPackHeader header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (header.magic != MAGIC || header.version != VERSION || header.bucket_count == 0 || header.slot_count == 0) {
+    spdlog::error("{} is not an asset pack of this version", path.string());
+    return;
+  }
+
+  u64 entries_offset = align_up(sizeof(AssetPackHeader) + u64{ header.bucket_count } * sizeof(u32), alignof(AssetPackEntry));
+  if (entries_offset + u64{ header.slot_count } * sizeof(AssetPackEntry) > data.size()) {
+    spdlog::error("Asset pack {} is truncated", path.string());
+    return;
+  }
+
+  seeds = { reinterpret_cast<const u32*>(data.data() + sizeof(AssetPackHeader)), header.bucket_count };
+  entries = { reinterpret_cast<const AssetPackEntry*>(data.data() + entries_offset), header.slot_count };
+  file_count = header.file_count;
+  spdlog::info("Mounted asset pack {}: {} files", path.filename().string(), file_count);
+}
+
+auto
+loki::AssetPack::find(std::string_view path) const -> const loki::AssetPackEntry*
+{
+  if (entries.empty()) {
+    return nullptr;
+  }
+
+  // Every hash lands on some slot, only the one it was placed in has it
+  u64 hash = MPQIndex::hash_path(path);
+  u32 seed = seeds[PerfectHash::get_bucket(hash, static_cast<u32>(seeds.size()))];
+  const AssetPackEntry& entry = entries[PerfectHash::get_slot(hash, seed, static_cast<u32>(entries.size()))];
+  return entry.hash == hash ? &entry : nullptr;
+}
+
+auto
+loki::AssetPack::read(const loki::AssetPackEntry& entry) const -> loki::MPQFileData
+{
+  auto data = mapping.get_span();
+  if (entry.offset + entry.stored_size > data.size()) {
+    spdlog::error("Asset pack entry {:016x} is out of bounds", entry.hash);
+    return MPQFileData{};
+  }
+
+  auto stored = data.subspan(entry.offset, entry.stored_size);
+  if (entry.compression == PackCompression::NONE) {
+    return MPQFileData{ stored };
+  }
+
+  LOKI_PROFILE_ZONE("Decompress asset pack file");
+  PooledBuffer buffer = buffer_pool->acquire(entry.size);
+  int size = LZ4_decompress_safe(reinterpret_cast<const char*>(stored.data()), reinterpret_cast<char*>(buffer.get_span().data()), static_cast<int>(entry.stored_size), static_cast<int>(entry.size));
+  if (size != static_cast<int>(entry.size)) {
+    spdlog::error("Asset pack entry {:016x} is corrupted", entry.hash);
+    return MPQFileData{};
+  }
+
+  return MPQFileData{ std::move(buffer) };
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+
+#include "engine/datasource/mpq/mpq_file.h"
+#include "engine/memory/buffer_pool.h"
+#include "engine/utils/mapped_file.h"
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  enum class PackCompression : u8
+  {
+    NONE = 0,
+    LZ4 = 1,
+  };
+
+  struct AssetPackHeader
+  {
+    u32 magic;
+    u32 version;
+    u32 file_count;
+    // Of the PerfectHash: a seed per bucket, then slot_count entries
+    u32 bucket_count;
+    u32 slot_count;
+    u32 reserved;
+  };
+
+  struct AssetPackEntry
+  {
+    // MPQIndex::hash_path of the name, 0 for an empty slot
+    u64 hash;
+    // From the start of the pack, a multiple of AssetPack::ALIGNMENT
+    u64 offset;
+    u32 size;
+    // What is in the pack, size when it's stored as it is
+    u32 stored_size;
+    PackCompression compression;
+    u8 reserved[7];
+  };
+
+  // Every live file of an MPQ chain in one file, written offline by loki_repack with the patch precedence
+  // resolved already. The directory is a perfect hash over the names' hashes, so a lookup is two reads,
+  // and each file is LZ4-compressed or stored as it is, on a 4 KiB boundary of its own. Stored files are
+  // read straight from the mapping. Mapped as a whole, thread-safe.
+  class AssetPack
+  {
+  public:
+    static constexpr u32 MAGIC = 0x4B'50'4B'4C; // "LKPK"
+    static constexpr u32 VERSION = 1;
+    static constexpr u64 ALIGNMENT = 0x1000;
+    // Decompressed files that have been let go of, kept for the next reads
+    static constexpr size_t BUFFER_POOL_SIZE = 0x400'0000;
+
+  public:
+    explicit AssetPack(const std::filesystem::path& path);
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+  public:
+    auto is_valid() const -> bool
+    {
+      return !entries.empty();
+    }
+
+    auto get_file_count() const -> u32
+    {
+      return file_count;
+    }
+
+    // Null when the pack doesn't have the file
+    auto find(std::string_view path) const -> const AssetPackEntry*;
+
+    auto has_file(std::string_view path) const -> bool
+    {
+      return find(path) != nullptr;
+    }
+
+    // The same as an MPQ file's: without a copy when it is stored as it is. Empty when it is corrupted.
+    auto read(const AssetPackEntry& entry) const -> MPQFileData;
+
+  private:
+    MappedFile mapping;
+    std::span<const u32> seeds;
+    std::span<const AssetPackEntry> entries;
+    u32 file_count{ 0 };
+    std::unique_ptr<BufferPool> buffer_pool;
+  };
+
+} // namespace loki
@@ -0,0 +1,222 @@
+#include "asset_pack_writer.h"
+
+#include <lz4hc.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "asset_pack.h"
+#include "engine/datasource/mpq/mpq_chain.h"
+#include "engine/jobs/job_system.h"
+#include "engine/time/profiler.h"
+#include "engine/utils/perfect_hash.h"
+#include "spdlog/spdlog.h"
+
+namespace {
+
+  struct PackedFile
+  {
+    std::string name;
+    loki::u64 hash;
+  };
+
+  // Read and compressed by a job, written by the main thread
+  struct Payload
+  {
+    std::vector<std::byte> data;
+    loki::u32 size{ 0 };
+    loki::PackCompression compression{ loki::PackCompression::NONE };
+    bool valid{ false };
+  };
+
+  // The chain's internal files ("(listfile)", "(attributes)", ...) are its own business
+  auto is_internal(std::string_view name) -> bool
+  {
+    return name.starts_with('(');
+  }
+
+  // Newest archive first, the first time a name comes up is the version that counts
+  auto collect_files(loki::MPQChain& chain) -> std::vector<PackedFile>
+  {
+    LOKI_PROFILE_ZONE("Collect MPQ chain files");
+
+    std::vector<PackedFile> files;
+    std::unordered_set<loki::u64> seen;
+    for (size_t i = 0; i < chain.get_archive_count(); ++i) {
+      loki::MPQArchive* archive = chain.get_archive(i);
+      if (!archive || !archive->is_valid()) {
+        continue;
+      }
+
+      SFILE_FIND_DATA data{};
+      HANDLE find = SFileFindFirstFile(archive->get_handle(), "*", &data, nullptr);
+      for (bool found = find != nullptr; found; found = SFileFindNextFile(find, &data)) {
+        loki::u64 hash = loki::MPQIndex::hash_path(data.cFileName);
+        if (is_internal(data.cFileName) || !seen.insert(hash).second) {
+          continue;
+        }
+
+        // The name stays seen, a deleted file mustn't come back from an older archive
+        if ((data.dwFileFlags & MPQ_FILE_DELETE_MARKER) == 0) {
+          files.push_back({ data.cFileName, hash });
+        }
+      }
+
+      if (find) {
+        SFileFindClose(find);
+      }
+    }
+
+    return files;
+  }
+
+  auto read_payload(loki::MPQChain& chain, const std::string& name, const loki::AssetPackSettings& settings) -> Payload
+  {
+    Payload payload;
+    loki::MPQFile file = chain.get_readers().open_file(name);
+    if (!file.is_valid() || file.get_size() > LZ4_MAX_INPUT_SIZE) {
+      return payload;
+    }
+
+    loki::MPQFileData data = file.read_all();
+    auto raw = data.get_span();
+    payload.size = static_cast<loki::u32>(raw.size());
+    payload.valid = true;
+
+    if (!raw.empty()) {
+      payload.data.resize(static_cast<size_t>(LZ4_compressBound(static_cast<int>(raw.size()))));
+      int size = LZ4_compress_HC(reinterpret_cast<const char*>(raw.data()), reinterpret_cast<char*>(payload.data.data()), static_cast<int>(raw.size()), static_cast<int>(payload.data.size()), settings.compression_level);
+      if (size > 0 && static_cast<double>(size) <= static_cast<double>(raw.size()) * (1.0 - settings.min_saving)) {
+        payload.data.resize(static_cast<size_t>(size));
+        payload.compression = loki::PackCompression::LZ4;
+        return payload;
+      }
+    }
+
+    payload.data.assign(raw.begin(), raw.end());
+    return payload;
+  }
+
+  auto align_up(loki::u64 value, loki::u64 alignment) -> loki::u64
+  {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+} // namespace
+
+auto
+loki::write_asset_pack(loki::MPQChain& chain, const std::filesystem::path& path, const loki::AssetPackSettings& settings, loki::AssetPackWriteStats& stats) -> bool
+{
+  LOKI_PROFILE_ZONE("Write asset pack");
+  chain.wait_until_loaded();
+
+  auto files = collect_files(chain);
+  std::vector<u64> hashes(files.size());
+  std::transform(files.begin(), files.end(), hashes.begin(), [](const PackedFile& packed) {
+    return packed.hash;
+  });
+
+  auto perfect_hash = PerfectHash::build(hashes);
+  if (!perfect_hash.is_valid()) {
+    spdlog::error("No perfect hash found for {} files", files.size());
+    return false;
+  }
+
+  AssetPackHeader header{};
+  header.magic = AssetPack::MAGIC;
+  header.version = AssetPack::VERSION;
+  header.file_count = static_cast<u32>(files.size());
+  header.bucket_count = static_cast<u32>(perfect_hash.get_seeds().size());
+  header.slot_count = perfect_hash.get_slot_count();
+
+  u64 entries_offset = align_up(sizeof(AssetPackHeader) + perfect_hash.get_seeds().size() * sizeof(u32), alignof(AssetPackEntry));
+  u64 offset = align_up(entries_offset + u64{ header.slot_count } * sizeof(AssetPackEntry), AssetPack::ALIGNMENT);
+  std::vector<AssetPackEntry> entries(header.slot_count);
+
+  auto temp_path = path;
+  temp_path += ".tmp";
+  std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    spdlog::error("Failed to create {}", temp_path.string());
+    return false;
+  }
+
+  stats = {};
+  std::vector<Payload> payloads(std::max(settings.batch_size, 1u));
+  for (size_t begin = 0; begin < files.size(); begin += payloads.size()) {
+    auto count = static_cast<u32>(std::min(payloads.size(), files.size() - begin));
+    auto read = [&chain, &files, &payloads, &settings, begin](u32 first, u32 last) {
+      for (u32 i = first; i < last; ++i) {
+        payloads[i] = read_payload(chain, files[begin + i].name, settings);
+      }
+    };
+
+    if (JobSystem::is_initialized()) {
+      JobCounter counter;
+      JobSystem::parallel_for(count, 1, read, counter);
+      JobSystem::wait(counter);
+    } else {
+      read(0, count);
+    }
+
+    // In the order they were collected, so the pack is the same every time for the same archives
+    for (u32 i = 0; i < count; ++i) {
+      Payload& payload = payloads[i];
+      const PackedFile& packed = files[begin + i];
+      if (!payload.valid) {
+        spdlog::warn("Skipping {}, it can't be read", packed.name);
+        continue;
+      }
+
+      AssetPackEntry& entry = entries[perfect_hash.get_key_slot(begin + i)];
+      entry.hash = packed.hash;
+      entry.offset = offset;
+      entry.size = payload.size;
+      entry.stored_size = static_cast<u32>(payload.data.size());
+      entry.compression = payload.compression;
+
+      file.seekp(static_cast<std::streamoff>(offset));
+      file.write(reinterpret_cast<const char*>(payload.data.data()), static_cast<std::streamsize>(payload.data.size()));
+      offset = align_up(offset + payload.data.size(), AssetPack::ALIGNMENT);
+
+      stats.file_count++;
+      stats.compressed_count += payload.compression != PackCompression::NONE;
+      stats.raw_bytes += payload.size;
+      payload = {};
+    }
+
+    spdlog::info("Packed {} of {} files", std::min(begin + count, files.size()), files.size());
+  }
+
+  // Files that couldn't be read have no entry, they simply aren't found
+  header.file_count = stats.file_count;
+  stats.pack_bytes = offset;
+
+  // The last payload's padding, so every payload is a whole number of pages in the file too
+  file.seekp(static_cast<std::streamoff>(offset - 1));
+  file.put('\0');
+
+  file.seekp(0);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(perfect_hash.get_seeds().data()), static_cast<std::streamsize>(perfect_hash.get_seeds().size() * sizeof(u32)));
+  file.seekp(static_cast<std::streamoff>(entries_offset));
+  file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(AssetPackEntry)));
+  file.close();
+  if (!file) {
+    spdlog::error("Failed to write {}", temp_path.string());
+    return false;
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temp_path, path, error);
+  if (error) {
+    spdlog::error("Failed to store {}: {}", path.string(), error.message());
+    std::filesystem::remove(temp_path, error);
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <filesystem>
+
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  class MPQChain;
+
+  struct AssetPackSettings
+  {
+    // LZ4HC, 3 to 12. Slower to write, not to read.
+    int compression_level{ 9 };
+    // Stored as it is unless LZ4 makes it at least this much smaller, raw files are read without a copy
+    double min_saving{ 0.1 };
+    // Files read and compressed at once on the job system before they are written out in order
+    u32 batch_size{ 0x100 };
+  };
+
+  struct AssetPackWriteStats
+  {
+    u32 file_count{ 0 };
+    u32 compressed_count{ 0 };
+    u64 raw_bytes{ 0 };
+    // Alignment padding included
+    u64 pack_bytes{ 0 };
+  };
+
+  // Every file the chain's listfiles name, the newest archive's version of it, into a pack AssetPack can
+  // mount. Files a patch deleted are left out. Waits until the chain is loaded, the files are read through
+  // its reader pool and compressed on the job system. Written to a temporary file and renamed once done.
+  auto write_asset_pack(MPQChain& chain, const std::filesystem::path& path, const AssetPackSettings& settings, AssetPackWriteStats& stats) -> bool;
+
+} // namespace loki
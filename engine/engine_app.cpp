@@ -2,12 +2,55 @@
 
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
+#include "jobs/job_system.h"
+#include "memory/allocation_counter.h"
+#include "render/frame_pipeline.h"
+#include "render/program_cache.h"
+#include "render/shader.h"
 #include "spdlog/spdlog.h"
-#include "time/scope_timer.h"
+#include "time/profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+  // Per frame in flight, enough for a few thousand draws' uniform blocks plus UI-sized vertex streams
+  constexpr loki::u32 STREAM_BUFFER_FRAME_SIZE = 4 * 1'024 * 1'024;
+
+  // A long stall (a breakpoint, a window drag) would otherwise be caught up on in one burst of updates
+  constexpr double MAX_FRAME_TIME = 0.25;
+  // When simulating costs more than the time it covers, drop time instead of falling further behind
+  constexpr loki::u32 MAX_UPDATES_PER_FRAME = 8;
+
+  // Milliseconds since the previous lap
+  class LapTimer
+  {
+  public:
+    auto get_start() const -> std::chrono::steady_clock::time_point
+    {
+      return start;
+    }
+
+    auto lap() -> double
+    {
+      auto now = std::chrono::steady_clock::now();
+      double ms = std::chrono::duration<double, std::milli>(now - last).count();
+      last = now;
+      return ms;
+    }
+
+  private:
+    std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+    std::chrono::steady_clock::time_point last{ start };
+  };
+
+} // namespace
 
 loki::EngineApp::~EngineApp()
 {
-  if (window) {
+  if (initialized) {
     on_term();
   }
 }
@@ -17,45 +60,444 @@ loki::EngineApp::launch(const std::shared_ptr<EngineSettings>& _settings) -> int
 {
   settings = _settings;
 
-  if (!on_init()) {
+  LOKI_PROFILE_THREAD("Main");
+  Profiler::set_enabled(settings->profiler);
+  JobSystem::init({ settings->job_workers, settings->pin_job_workers });
+
+  // Waits for the archives the game needs, speech archives keep opening while the window and GL come up.
+  // A pack is only mapped, there's nothing to wait for.
+  auto data_dir = settings->root_path / "Data";
+  size_t mpq_cache_size = static_cast<size_t>(settings->mpq_cache_size) << 20;
+  if (!settings->asset_pack_path.empty()) {
+    asset_pack = std::make_unique<AssetPack>(settings->asset_pack_path);
+    if (asset_pack->is_valid() && mpq_cache_size > 0) {
+      mpq_cache = std::make_unique<MPQFileCache>(*asset_pack, mpq_cache_size);
+    }
+  } else if (std::filesystem::is_directory(data_dir)) {
+    mpq_chain = std::make_unique<MPQChain>(data_dir, settings->cache_path / "mpq_index.bin");
+    if (mpq_cache_size > 0) {
+      mpq_cache = std::make_unique<MPQFileCache>(*mpq_chain, mpq_cache_size);
+    }
+  }
+
+  initialized = on_init();
+  if (!initialized) {
     window = nullptr;
+    JobSystem::term();
     return 1;
   }
 
+  // Startup shader cost, compare a cold cache (empty cache directory) to a warm one
+  auto program_stats = ShaderManager::get_program_stats();
+  if (program_stats.loaded_from_cache + program_stats.linked_from_source > 0) {
+    spdlog::info("Shader programs: {} loaded from cache, {} linked from source, {:.2f} ms total", program_stats.loaded_from_cache, program_stats.linked_from_source,
+        program_stats.seconds * 1'000.0);
+  }
+
   // Unbind VAO, VBO, and EBO
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-  while (!glfwWindowShouldClose(window)) {
-    loki::ScopeTimer scope_timer{ delta_time };
+  if (is_headless()) {
+    frame_timings.reserve(settings->headless_frames);
+  }
 
-    // Main update
-    on_update();
+  fixed_delta_time = 1.f / static_cast<float>(std::max(settings->update_rate, 1u));
+  frame_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / std::max(settings->frame_cap, 1u)));
+  next_frame = std::chrono::steady_clock::now();
+
+  if (settings->render_thread) {
+    run_pipelined();
+  } else {
+    run_serial();
+  }
+
+  if (settings->trace_on_exit) {
+    Profiler::write_chrome_trace(settings->trace_path);
+  }
+
+  if (is_headless()) {
+    frame_timings.log_summary();
+    return frame_timings.write(settings->frame_timings_path) ? 0 : 1;
+  }
+
+  return 0;
+}
+
+auto
+loki::EngineApp::is_running() const -> bool
+{
+  return is_headless() ? frame_index < settings->headless_frames : !glfwWindowShouldClose(window);
+}
+
+void
+loki::EngineApp::run_serial()
+{
+  while (is_running()) {
+    LOKI_PROFILE_FRAME();
+    LOKI_PROFILE_ZONE("Frame");
+    LapTimer lap_timer;
+    FrameTiming timing;
+    u64 allocation_start = get_thread_allocation_count();
+    frame_arena.begin_frame();
+
+    // Finish whatever shaders the driver compiled in the background since the last frame
+    poll_programs();
+    JobSystem::run_main_thread_jobs();
+
+    if (headless_context) {
+      headless_context->bind_framebuffer();
+    }
+
+    stream_buffer.begin_frame();
+    gpu_timers.begin_frame();
+    render_queue.reset();
+
+    simulate(timing);
+    timing.update_ms = lap_timer.lap();
 
     // Draw main scene
-    on_render();
+    record_frame();
+    submit_queue(render_queue);
+    render_stats = render_queue.get_stats();
+    stream_stats = stream_buffer.get_stats();
+    timing.render_ms = lap_timer.lap();
 
     // Start the Dear ImGui frame
     ImGui_ImplOpenGL3_NewFrame();
+    build_gui();
+    render_gui(ImGui::GetDrawData());
+    gpu_timers.end_frame();
+    gpu_timings = gpu_timers.get_timings();
+    timing.gui_ms = lap_timer.lap();
+
+    present();
+    if (headless_context) {
+      timing.finish_ms = lap_timer.lap();
+    } else {
+      glfwPollEvents();
+    }
+
+    timing.allocations = static_cast<u32>(get_thread_allocation_count() - allocation_start);
+    finish_frame(timing, lap_timer.get_start());
+  }
+}
+
+void
+loki::EngineApp::run_pipelined()
+{
+  FramePipeline pipeline;
+
+  // From here on the context belongs to the render thread, until it's handed back for on_term()
+  release_context();
+  std::thread render_thread{ [this, &pipeline]() {
+    LOKI_PROFILE_THREAD("Render");
+    render_loop(pipeline);
+  } };
+
+  while (is_running()) {
+    LOKI_PROFILE_FRAME();
+    LOKI_PROFILE_ZONE("Frame");
+    LapTimer lap_timer;
+    FrameTiming timing;
+    u64 allocation_start = get_thread_allocation_count();
+
+    // Blocks while the render thread is still drawing the frame before the last one
+    FramePacket& packet = pipeline.acquire();
+    // Which makes that frame's arena free to reuse
+    frame_arena.begin_frame();
+    JobSystem::run_main_thread_jobs();
+    timing.finish_ms = lap_timer.lap();
+    timing.render_thread_ms = packet.render_thread_ms;
+    render_stats = packet.queue.get_stats();
+    stream_stats = packet.stream_stats;
+    gpu_timings = packet.gpu_timings;
+
+    active_queue = &packet.queue;
+    packet.queue.reset();
+
+    simulate(timing);
+    timing.update_ms = lap_timer.lap();
+
+    // Only records, the draws happen on the render thread
+    record_frame();
+    timing.render_ms = lap_timer.lap();
+
+    build_gui();
+    {
+      LOKI_PROFILE_ZONE("Snapshot GUI");
+      packet.gui.capture(*ImGui::GetDrawData());
+    }
+
+    timing.gui_ms = lap_timer.lap();
+
+    pipeline.publish();
+    if (!headless_context) {
+      glfwPollEvents();
+    }
+
+    timing.allocations = static_cast<u32>(get_thread_allocation_count() - allocation_start);
+    finish_frame(timing, lap_timer.get_start());
+  }
+
+  pipeline.stop();
+  render_thread.join();
+
+  active_queue = &render_queue;
+  make_context_current();
+}
+
+void
+loki::EngineApp::render_loop(loki::FramePipeline& pipeline)
+{
+  make_context_current();
+
+  while (FramePacket* packet = pipeline.consume()) {
+    LOKI_PROFILE_ZONE("Render frame");
+    LapTimer lap_timer;
+
+    // The shader manager is only ever touched by the thread that has the context
+    poll_programs();
+
+    if (headless_context) {
+      headless_context->bind_framebuffer();
+    }
+
+    stream_buffer.begin_frame();
+    gpu_timers.begin_frame();
+    submit_queue(packet->queue);
+
+    ImGui_ImplOpenGL3_NewFrame();
+    render_gui(packet->gui.get_draw_data());
+    gpu_timers.end_frame();
+
+    present();
+    packet->render_thread_ms = lap_timer.lap();
+    packet->stream_stats = stream_buffer.get_stats();
+    packet->gpu_timings = gpu_timers.get_timings();
+    pipeline.release();
+  }
+
+  release_context();
+}
+
+void
+loki::EngineApp::simulate(loki::FrameTiming& timing)
+{
+  LOKI_PROFILE_ZONE("Simulate");
+
+  // Simulate in fixed steps whatever the frame rate is. A headless run takes exactly one step per frame,
+  // so what it renders doesn't depend on how fast the machine renders it.
+  accumulator += is_headless() ? fixed_delta_time : std::min<double>(delta_time, MAX_FRAME_TIME);
+  while (accumulator >= fixed_delta_time) {
+    if (timing.updates == MAX_UPDATES_PER_FRAME) {
+      accumulator = 0.0;
+      break;
+    }
+
+    // Main update
+    {
+      LOKI_PROFILE_ZONE("Update");
+      on_update();
+    }
+
+    accumulator -= fixed_delta_time;
+    ++timing.updates;
+    ++update_index;
+  }
+
+  // How far the renderer is between the last two simulation states
+  interpolation_alpha = static_cast<float>(accumulator / fixed_delta_time);
+}
+
+void
+loki::EngineApp::poll_programs()
+{
+  LOKI_PROFILE_ZONE("Poll programs");
+  ShaderManager::poll_programs();
+}
+
+void
+loki::EngineApp::record_frame()
+{
+  LOKI_PROFILE_ZONE("Record");
+  on_render();
+}
+
+void
+loki::EngineApp::submit_queue(loki::RenderQueue& queue)
+{
+  LOKI_PROFILE_ZONE("Submit");
+
+  {
+    LOKI_PROFILE_ZONE("Sort");
+    queue.sort();
+  }
+
+  {
+    LOKI_PROFILE_ZONE("Upload");
+    queue.upload(stream_buffer);
+    stream_buffer.flush();
+  }
+
+  {
+    LOKI_PROFILE_ZONE("Draw");
+    queue.submit(gpu_timers);
+  }
+
+  stream_buffer.end_frame();
+}
+
+void
+loki::EngineApp::render_gui(ImDrawData* draw_data)
+{
+  LOKI_PROFILE_ZONE("Render GUI");
+  GpuTimerScope gpu_zone{ gpu_timers, "ImGui" };
+  ImGui_ImplOpenGL3_RenderDrawData(draw_data);
+}
+
+void
+loki::EngineApp::build_gui()
+{
+  LOKI_PROFILE_ZONE("Build GUI");
+
+  if (headless_context) {
+    // No platform backend without a window, feed ImGui the offscreen size and a time step by hand
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2{ static_cast<float>(settings->window_width), static_cast<float>(settings->window_height) };
+    io.DeltaTime = delta_time > 0.f ? delta_time : 1.f / 60.f;
+  } else {
     ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
+  }
 
-    // Draw UI
-    on_gui();
+  ImGui::NewFrame();
 
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  // Draw UI
+  on_gui();
 
+  ImGui::Render();
+}
+
+void
+loki::EngineApp::present()
+{
+  LOKI_PROFILE_ZONE("Present");
+
+  if (headless_context) {
+    // Nothing to present, wait for the frame instead so the timings include the GL work itself
+    glFinish();
+  } else {
     glfwSwapBuffers(window);
-    glfwPollEvents();
   }
+}
 
-  return 0;
+void
+loki::EngineApp::finish_frame(loki::FrameTiming& timing, std::chrono::steady_clock::time_point frame_start)
+{
+  bool frame_capped = settings->frame_cap && !settings->unlimited_frame_rate && !is_headless();
+  if (frame_capped) {
+    LOKI_PROFILE_ZONE("Frame cap");
+
+    // Sleep to the next frame boundary, a frame that ran late starts the schedule over instead of rushing
+    next_frame += frame_period;
+    auto now = std::chrono::steady_clock::now();
+    if (next_frame > now) {
+      std::this_thread::sleep_until(next_frame);
+    } else {
+      next_frame = now;
+    }
+  }
+
+  // Includes the cap sleep, the simulation has to cover the whole frame
+  double elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - frame_start).count();
+  delta_time = static_cast<float>(elapsed_seconds);
+  timing.frame_ms = elapsed_seconds * 1'000.0;
+  if (is_headless()) {
+    frame_timings.record(timing);
+  }
+
+  last_frame_timing = timing;
+  ++frame_index;
+}
+
+void
+loki::EngineApp::make_context_current()
+{
+  if (headless_context) {
+    headless_context->make_current();
+  } else {
+    glfwMakeContextCurrent(window);
+  }
+}
+
+void
+loki::EngineApp::release_context()
+{
+  if (headless_context) {
+    headless_context->release_current();
+  } else {
+    glfwMakeContextCurrent(nullptr);
+  }
 }
 
 bool
 loki::EngineApp::on_init()
+{
+  // Set error callback
+  glfwSetErrorCallback([](int error, const char* description) {
+    spdlog::error("Code: {}, description: {}", error, description);
+  });
+
+  if (is_headless()) {
+    headless_context = std::make_unique<HeadlessContext>();
+    if (!headless_context->create(settings->window_width, settings->window_height)) {
+      headless_context.reset();
+      glfwTerminate();
+      return false;
+    }
+
+    window = headless_context->get_window();
+  } else if (!create_window()) {
+    return false;
+  }
+
+  ProgramBinaryCache::set_directory(settings->cache_path / "shaders");
+  ShaderManager::init();
+
+  if (!stream_buffer.init(STREAM_BUFFER_FRAME_SIZE)) {
+    return false;
+  }
+
+  // Optional, the GPU lane of the profiler just stays empty without it
+  gpu_timers.init();
+
+  // Setup Dear ImGui context
+  IMGUI_CHECKVERSION();
+
+  ImGui::CreateContext();
+  ImGuiIO& io = ImGui::GetIO();
+  io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+  io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;
+  io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+
+  // Setup Dear ImGui style
+  ImGui::StyleColorsLight();
+
+  if (!headless_context) {
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+  }
+
+  ImGui_ImplOpenGL3_Init("#version 330");
+
+  // The font atlas has to exist before the first ImGui::NewFrame(), which a render thread wouldn't guarantee
+  ImGui_ImplOpenGL3_CreateDeviceObjects();
+
+  return true;
+}
+
+auto
+loki::EngineApp::create_window() -> bool
 {
   if (!glfwInit()) {
     spdlog::error("Failed to initialize GLFW!");
@@ -71,13 +513,8 @@ loki::EngineApp::on_init()
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-  // Set error callback
-  glfwSetErrorCallback([](int error, const char* description) {
-    spdlog::error("Code: {}, description: {}", error, description);
-  });
-
   // Create a windowed mode window and its OpenGL context
-  window = glfwCreateWindow(1'920, 1'080, "Loki Engine", nullptr, nullptr);
+  window = glfwCreateWindow(settings->window_width, settings->window_height, "Loki Engine", nullptr, nullptr);
   if (!window) {
     spdlog::error("Failed to create GLFW window!");
     glfwTerminate();
@@ -87,40 +524,52 @@ loki::EngineApp::on_init()
   // Make the window's context current
   glfwMakeContextCurrent(window);
 
-  // VSYNC
-  glfwSwapInterval(1);
+  // VSYNC, unless the frame rate is capped by hand or not at all
+  glfwSwapInterval(settings->frame_cap || settings->unlimited_frame_rate ? 0 : 1);
 
   if (glewInit()) {
     spdlog::error("Failed to initialize GLEW!");
     return false;
   }
 
-  // Setup Dear ImGui context
-  IMGUI_CHECKVERSION();
-
-  ImGui::CreateContext();
-  ImGuiIO& io = ImGui::GetIO();
-  io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
-  io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;
-  io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
-
-  // Setup Dear ImGui style
-  ImGui::StyleColorsLight();
+  return true;
+}
 
-  ImGui_ImplGlfw_InitForOpenGL(window, true);
-  ImGui_ImplOpenGL3_Init("#version 330");
+auto
+loki::EngineApp::get_window_size() const -> glm::ivec2
+{
+  if (headless_context) {
+    return { settings->window_width, settings->window_height };
+  }
 
-  return true;
+  glm::ivec2 window_size;
+  glfwGetWindowSize(window, &window_size.x, &window_size.y);
+  return window_size;
 }
 
 void
 loki::EngineApp::on_term()
 {
+  // Jobs still queued may need anything below
+  JobSystem::term();
+  mpq_cache.reset();
+  mpq_chain.reset();
+  asset_pack.reset();
+
   // Some ImGui cleanups here
   ImGui_ImplOpenGL3_Shutdown();
-  ImGui_ImplGlfw_Shutdown();
+  if (!headless_context) {
+    ImGui_ImplGlfw_Shutdown();
+  }
+
   ImGui::DestroyContext();
 
+  // Needs the context, so before it goes away with the window
+  stream_buffer.term();
+  gpu_timers.term();
+  headless_context.reset();
+
   glfwTerminate();
   window = nullptr;
+  initialized = false;
 }
@@ -7,15 +7,60 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "datasource/mpq/mpq_chain.h"
+#include "datasource/mpq/mpq_file_cache.h"
+#include "datasource/pack/asset_pack.h"
+#include "memory/linear_arena.h"
+#include "memory/memory_domain.h"
+#include "render/frame_pipeline.h"
+#include "render/gpu_timer.h"
+#include "render/headless_context.h"
+#include "render/render_queue.h"
+#include "render/stream_buffer.h"
+#include "time/frame_timings.h"
+#include "utils/types.h"
+
+#include "glm/vec2.hpp"
+
+#include <chrono>
 #include <filesystem>
 #include <memory>
 #include <utility>
+#include <vector>
 
 namespace loki {
 
   struct EngineSettings
   {
     std::filesystem::path root_path;
+    std::filesystem::path cache_path{ "cache" };
+    i32 window_width{ 1'920 };
+    i32 window_height{ 1'080 };
+    // Simulation steps per second, on_update() always advances by the same fixed delta time
+    u32 update_rate{ 60 };
+    // 0 leaves the frame rate to vsync, otherwise vsync is off and frames are paced to this many per second
+    u32 frame_cap{ 0 };
+    // Neither vsync nor a cap, as many frames as the machine can render
+    bool unlimited_frame_rate{ false };
+    // Draw on a thread of its own, one frame behind the simulation. on_render() then only records into
+    // the render queue, and GL (shaders included) is off limits to the main thread after on_init().
+    bool render_thread{ false };
+    // Offscreen benchmark run: nothing is shown, no vsync, a fixed number of frames and a CSV of their timings
+    bool headless{ false };
+    u32 headless_frames{ 1'000 };
+    std::filesystem::path frame_timings_path{ "frame_timings.csv" };
+    // Job system threads, the main thread included, 0 for one per hardware thread
+    u32 job_workers{ 0 };
+    bool pin_job_workers{ false };
+    // Written by loki_repack, mounted instead of the Data directory's MPQ chain when set
+    std::filesystem::path asset_pack_path;
+    // Decompressed MPQ files kept for the next request, in MiB, 0 turns the cache off
+    u32 mpq_cache_size{ 256 };
+    // CPU zones are recorded unless this is off, the Profiler window can still turn them on later
+    bool profiler{ true };
+    // Where the Profiler window saves traces, also written on exit when trace_on_exit is set
+    std::filesystem::path trace_path{ "trace.json" };
+    bool trace_on_exit{ false };
   };
 
   class EngineApp
@@ -35,11 +80,28 @@ namespace loki {
     virtual void on_gui() = 0;
 
   protected:
+    // Wall time of the last frame, on_update() should use get_fixed_delta_time() instead
     auto get_delta_time() const -> float
     {
       return delta_time;
     }
 
+    auto get_fixed_delta_time() const -> float
+    {
+      return fixed_delta_time;
+    }
+
+    // 0..1 between the previous and the latest simulation state, on_render() blends the two with it
+    auto get_interpolation_alpha() const -> float
+    {
+      return interpolation_alpha;
+    }
+
+    auto get_last_frame_timing() const -> const FrameTiming&
+    {
+      return last_frame_timing;
+    }
+
     auto get_fps() const -> float
     {
       return delta_time != 0.f ? 1.f / delta_time : 0.f;
@@ -50,15 +112,152 @@ namespace loki {
       return settings->root_path;
     }
 
+    // The root's Data directory, null without one. Speech archives may still be opening.
+    auto get_mpq_chain() -> MPQChain*
+    {
+      return mpq_chain.get();
+    }
+
+    // Null unless one was given, there is no MPQ chain then
+    auto get_asset_pack() -> AssetPack*
+    {
+      return asset_pack.get();
+    }
+
+    // In front of the asset pack or the MPQ chain, null without either or with the cache turned off
+    auto get_mpq_cache() -> MPQFileCache*
+    {
+      return mpq_cache.get();
+    }
+
+    // Null in a surfaceless headless run
     auto get_window() const -> GLFWwindow*
     {
       return window;
     }
 
+    // The offscreen framebuffer size in a headless run
+    auto get_window_size() const -> glm::ivec2;
+
+    auto is_headless() const -> bool
+    {
+      return settings->headless;
+    }
+
+    auto get_headless_frames() const -> u32
+    {
+      return settings->headless_frames;
+    }
+
+    auto get_frame_index() const -> u64
+    {
+      return frame_index;
+    }
+
+    // Simulation steps since launch, a scripted camera path keyed on it renders the same frames on every run
+    auto get_update_index() const -> u64
+    {
+      return update_index;
+    }
+
+    // Commands recorded in on_render are sorted and submitted right after it returns, or by the render thread
+    auto get_render_queue() -> RenderQueue&
+    {
+      return *active_queue;
+    }
+
+    // Of the last frame that finished drawing, which is one behind with a render thread
+    auto get_render_stats() const -> const RenderStats&
+    {
+      return render_stats;
+    }
+
+    // Per-frame uniform and dynamic vertex data, allocations are valid from on_update until the queue is submitted.
+    // With a render thread the buffer is that thread's, the main thread only reads its stats.
+    auto get_stream_buffer() -> StreamBuffer&
+    {
+      return stream_buffer;
+    }
+
+    auto get_stream_stats() const -> const StreamStats&
+    {
+      return stream_stats;
+    }
+
+    // Frames behind the CPU side, the GPU timings are read back without waiting for the GPU
+    auto get_gpu_timings() const -> const std::vector<GpuTiming>&
+    {
+      return gpu_timings;
+    }
+
+    // Transient allocations of the current frame (on_update, on_render, on_gui), freed two frames later.
+    // Main thread only.
+    auto get_frame_resource() -> std::pmr::memory_resource*
+    {
+      return frame_arena.get_resource();
+    }
+
+    auto get_frame_arena_stats() const -> const ArenaStats&
+    {
+      return frame_arena.get_stats();
+    }
+
+    auto get_trace_path() const -> const std::filesystem::path&
+    {
+      return settings->trace_path;
+    }
+
+  private:
+    auto create_window() -> bool;
+    auto is_running() const -> bool;
+
+    void run_serial();
+    void run_pipelined();
+    void render_loop(FramePipeline& pipeline);
+
+    void poll_programs();
+    void simulate(FrameTiming& timing);
+    void record_frame();
+    void submit_queue(RenderQueue& queue);
+    void build_gui();
+    void render_gui(ImDrawData* draw_data);
+    void present();
+    // Paces the frame to the cap and sets the delta time from frame_start, the sleep included
+    void finish_frame(FrameTiming& timing, std::chrono::steady_clock::time_point frame_start);
+
+    void make_context_current();
+    void release_context();
+
+  private:
+    static constexpr size_t FRAME_ARENA_SIZE = 0x10'0000;
+
   private:
     std::shared_ptr<EngineSettings> settings{ nullptr };
+    bool initialized{ false };
     float delta_time{ 0.f };
+    float fixed_delta_time{ 1.f / 60.f };
+    float interpolation_alpha{ 0.f };
+    double accumulator{ 0.0 };
+    std::chrono::steady_clock::duration frame_period{};
+    std::chrono::steady_clock::time_point next_frame;
+    u64 frame_index{ 0 };
+    u64 update_index{ 0 };
+    FrameTiming last_frame_timing;
     GLFWwindow* window{ nullptr };
+    std::unique_ptr<HeadlessContext> headless_context;
+    FrameTimingLog frame_timings;
+    RenderQueue render_queue;
+    RenderQueue* active_queue{ &render_queue };
+    RenderStats render_stats;
+    StreamStats stream_stats;
+    StreamBuffer stream_buffer;
+    // Only touched by the thread that has the context, like the stream buffer
+    GpuTimerPool gpu_timers;
+    std::vector<GpuTiming> gpu_timings;
+    FrameArena frame_arena{ FRAME_ARENA_SIZE, get_memory_resource(MemoryDomain::FRAME) };
+    std::unique_ptr<MPQChain> mpq_chain;
+    std::unique_ptr<AssetPack> asset_pack;
+    std::unique_ptr<MPQFileCache> mpq_cache;
   };
 
 } // namespace loki
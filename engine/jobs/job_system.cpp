@@ -0,0 +1,390 @@
+#include "job_system.h"
+
+#include <deque>
+#include <format>
+#include <memory>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "engine/jobs/work_stealing_deque.h"
+#include "engine/time/profiler.h"
+#include "libassert/assert.hpp"
+#include "spdlog/spdlog.h"
+
+namespace {
+
+  // Failed rounds over every queue before an idle worker goes to sleep
+  constexpr loki::u32 IDLE_SPINS = 64;
+
+  struct alignas(64) Worker
+  {
+    loki::WorkStealingDeque<loki::Job, loki::JobSystem::DEQUE_CAPACITY> deque;
+    std::atomic<loki::u64> executed{ 0 };
+    std::atomic<loki::u64> stolen{ 0 };
+  };
+
+  // Mutex-protected, for jobs that can't go to a deque: submitted by other threads, or the deque was full
+  struct JobQueue
+  {
+    auto pop() -> loki::Job*
+    {
+      // Checked without the lock, it's empty nearly every time an idle worker looks
+      if (size.load(std::memory_order_acquire) == 0) {
+        return nullptr;
+      }
+
+      std::lock_guard lock(mutex);
+      if (jobs.empty()) {
+        return nullptr;
+      }
+
+      loki::Job* job = jobs.front();
+      jobs.pop_front();
+      size.fetch_sub(1, std::memory_order_relaxed);
+      return job;
+    }
+
+    void push(loki::Job* job)
+    {
+      std::lock_guard lock(mutex);
+      jobs.push_back(job);
+      size.fetch_add(1, std::memory_order_release);
+    }
+
+    std::mutex mutex;
+    std::deque<loki::Job*> jobs;
+    std::atomic<size_t> size{ 0 };
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::thread> threads;
+  JobQueue submitted;
+  JobQueue main_thread_jobs;
+
+  std::atomic<bool> running{ false };
+  // Bumped on every submit, sleeping workers wait for it to change
+  std::atomic<loki::u64> wake_epoch{ 0 };
+  std::atomic<loki::u32> sleeping{ 0 };
+
+  thread_local loki::u32 worker_index{ loki::JobSystem::NOT_A_WORKER };
+  thread_local loki::u32 steal_seed{ 0x9E37'79B9 };
+
+  void pin_thread(loki::u32 core)
+  {
+    unsigned int core_count = std::max(std::thread::hardware_concurrency(), 1u);
+    core %= core_count;
+
+#ifdef _WIN32
+    if (!SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{ 1 } << core)) {
+      spdlog::warn("Failed to pin a job worker to core {}", core);
+    }
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+      spdlog::warn("Failed to pin a job worker to core {}", core);
+    }
+#endif
+  }
+
+  void wake_workers()
+  {
+    wake_epoch.fetch_add(1, std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_seq_cst) > 0) {
+      wake_epoch.notify_one();
+    }
+  }
+
+  // Xorshift, so thieves don't all start with the same victim
+  auto next_victim(loki::u32 count) -> loki::u32
+  {
+    steal_seed ^= steal_seed << 13;
+    steal_seed ^= steal_seed >> 17;
+    steal_seed ^= steal_seed << 5;
+    return steal_seed % count;
+  }
+
+  auto find_job() -> loki::Job*
+  {
+    loki::u32 index = worker_index;
+    if (index != loki::JobSystem::NOT_A_WORKER) {
+      if (loki::Job* job = workers[index]->deque.pop()) {
+        return job;
+      }
+    }
+
+    if (index == 0) {
+      if (loki::Job* job = main_thread_jobs.pop()) {
+        return job;
+      }
+    }
+
+    if (loki::Job* job = submitted.pop()) {
+      return job;
+    }
+
+    auto count = static_cast<loki::u32>(workers.size());
+    loki::u32 first = next_victim(count);
+    for (loki::u32 i = 0; i < count; ++i) {
+      loki::u32 victim = (first + i) % count;
+      if (victim == index) {
+        continue;
+      }
+
+      if (loki::Job* job = workers[victim]->deque.steal()) {
+        if (index != loki::JobSystem::NOT_A_WORKER) {
+          workers[index]->stolen.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return job;
+      }
+    }
+
+    return nullptr;
+  }
+
+} // namespace
+
+void
+loki::JobSystem::init(const loki::JobSystemSettings& settings)
+{
+  DEBUG_ASSERT(!is_initialized(), "The job system is initialized already");
+
+  u32 count = settings.worker_count ? settings.worker_count : std::max(std::thread::hardware_concurrency(), 1u);
+
+  workers.clear();
+  for (u32 i = 0; i < count; ++i) {
+    workers.push_back(std::make_unique<Worker>());
+  }
+
+  worker_index = 0;
+  if (settings.pin_workers) {
+    pin_thread(0);
+  }
+
+  running.store(true, std::memory_order_release);
+  for (u32 i = 1; i < count; ++i) {
+    threads.emplace_back(worker_loop, i, settings.pin_workers);
+  }
+
+  spdlog::info("Job system: {} workers{}", count, settings.pin_workers ? ", pinned" : "");
+}
+
+void
+loki::JobSystem::term()
+{
+  if (!is_initialized()) {
+    return;
+  }
+
+  // Jobs can start more jobs, so run them all before the workers are gone
+  while (Job* job = find_job()) {
+    execute(*job);
+  }
+
+  running.store(false, std::memory_order_release);
+  wake_epoch.fetch_add(1, std::memory_order_seq_cst);
+  wake_epoch.notify_all();
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  threads.clear();
+
+  // Stragglers a worker started on its way out
+  while (Job* job = find_job()) {
+    execute(*job);
+  }
+
+  workers.clear();
+  worker_index = NOT_A_WORKER;
+}
+
+auto
+loki::JobSystem::is_initialized() -> bool
+{
+  return !workers.empty();
+}
+
+auto
+loki::JobSystem::get_worker_count() -> loki::u32
+{
+  return static_cast<u32>(workers.size());
+}
+
+auto
+loki::JobSystem::get_worker_index() -> loki::u32
+{
+  return worker_index;
+}
+
+void
+loki::JobSystem::wait(loki::JobCounter& counter, loki::JobWait mode)
+{
+  bool can_block = worker_index == 0 || worker_index == NOT_A_WORKER;
+  if (mode == JobWait::BLOCK && can_block) {
+    for (u32 value = counter.value.load(std::memory_order_acquire); value != 0; value = counter.value.load(std::memory_order_acquire)) {
+      counter.value.wait(value, std::memory_order_acquire);
+    }
+  }
+
+  while (!counter.is_done()) {
+    if (Job* job = find_job()) {
+      execute(*job);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void
+loki::JobSystem::run_main_thread_jobs()
+{
+  DEBUG_ASSERT(worker_index == 0, "Main thread jobs can only run on the thread that initialized the job system");
+
+  while (Job* job = main_thread_jobs.pop()) {
+    execute(*job);
+  }
+}
+
+auto
+loki::JobSystem::get_stats() -> std::vector<loki::JobWorkerStats>
+{
+  std::vector<JobWorkerStats> stats;
+  for (const auto& worker : workers) {
+    stats.push_back({ worker->executed.load(std::memory_order_relaxed), worker->stolen.load(std::memory_order_relaxed) });
+  }
+
+  return stats;
+}
+
+void
+loki::JobSystem::schedule(loki::Job* job)
+{
+  if (job->affinity == JobAffinity::MAIN_THREAD) {
+    main_thread_jobs.push(job);
+    return;
+  }
+
+  if (worker_index == NOT_A_WORKER || !workers[worker_index]->deque.push(job)) {
+    submitted.push(job);
+  }
+
+  wake_workers();
+}
+
+void
+loki::JobSystem::schedule_after(loki::JobCounter& dependency, loki::Job* job)
+{
+  {
+    // finish() takes the continuations under the same lock once the value is 0, one of us sees the other
+    std::lock_guard lock(dependency.mutex);
+    if (dependency.value.load(std::memory_order_acquire) != 0) {
+      dependency.continuations.push_back(job);
+      return;
+    }
+  }
+
+  // The job that took the dependency to 0 may not be out of it yet, see finish()
+  while (dependency.busy.load(std::memory_order_acquire) != 0) {
+    std::this_thread::yield();
+  }
+
+  schedule(job);
+}
+
+void
+loki::JobSystem::worker_loop(loki::u32 index, bool pin)
+{
+  worker_index = index;
+  // Never 0, xorshift would be stuck there
+  steal_seed = (0x9E37'79B9 ^ (index * 0x85EB'CA6B)) | 1;
+  LOKI_PROFILE_THREAD(std::format("Job worker {}", index));
+
+  if (pin) {
+    pin_thread(index);
+  }
+
+  u32 idle = 0;
+  while (running.load(std::memory_order_acquire)) {
+    if (Job* job = find_job()) {
+      execute(*job);
+      idle = 0;
+      continue;
+    }
+
+    if (++idle < IDLE_SPINS) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Look once more after announcing the sleep, a job submitted in between bumped the epoch already
+    sleeping.fetch_add(1, std::memory_order_seq_cst);
+    u64 epoch = wake_epoch.load(std::memory_order_seq_cst);
+    Job* job = find_job();
+    if (!job && running.load(std::memory_order_acquire)) {
+      wake_epoch.wait(epoch, std::memory_order_seq_cst);
+    }
+
+    sleeping.fetch_sub(1, std::memory_order_relaxed);
+    if (job) {
+      execute(*job);
+    }
+
+    idle = 0;
+  }
+}
+
+void
+loki::JobSystem::execute(loki::Job& job)
+{
+  job.invoke(job);
+  job.destroy(job);
+
+  if (worker_index != NOT_A_WORKER) {
+    workers[worker_index]->executed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (JobCounter* counter = job.counter) {
+    finish(*counter);
+  }
+
+  delete &job;
+}
+
+void
+loki::JobSystem::finish(loki::JobCounter& counter)
+{
+  counter.busy.fetch_add(1, std::memory_order_seq_cst);
+
+  std::vector<Job*> ready;
+  if (counter.value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    {
+      std::lock_guard lock(counter.mutex);
+      ready.swap(counter.continuations);
+    }
+
+    counter.value.notify_all();
+
+    // Jobs that decremented before us may not be out of the counter yet, and it could be freed as soon
+    // as a continuation is done. The window is a couple of instructions wide.
+    while (!ready.empty() && counter.busy.load(std::memory_order_acquire) != 1) {
+      std::this_thread::yield();
+    }
+  }
+
+  counter.busy.fetch_sub(1, std::memory_order_release);
+
+  // Only once we're out of the counter, whoever waits on a continuation may free it when that is done
+  for (Job* job : ready) {
+    schedule(job);
+  }
+}
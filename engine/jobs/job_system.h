@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  enum class JobAffinity : u8
+  {
+    // Whichever worker gets to it first, the main thread included
+    ANY = 0,
+    // Only the main thread runs it, while it helps in wait() or in run_main_thread_jobs(). For ImGui,
+    // GLFW, or GL when there's no render thread.
+    MAIN_THREAD = 1,
+  };
+
+  enum class JobWait : u8
+  {
+    // Run other jobs until the counter is done
+    HELP = 0,
+    // Sleep until the counter is done. Main thread jobs don't run meanwhile, so none may be waited on.
+    BLOCK = 1,
+  };
+
+  struct Job;
+
+  // Number of jobs still to finish. A job started with a counter increments it and decrements it when it
+  // is done, run_after() holds a job back until a counter gets to 0. One counter can cover any number of
+  // jobs, and it can be reused once it is done. It has to outlive every job that refers to it.
+  class JobCounter
+  {
+  public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+  public:
+    auto is_done() const -> bool
+    {
+      return value.load(std::memory_order_acquire) == 0 && busy.load(std::memory_order_acquire) == 0;
+    }
+
+  private:
+    friend struct JobSystem;
+
+  private:
+    std::atomic<u32> value{ 0 };
+    // Jobs in the middle of decrementing, the counter can't be done (and freed) before they are out of it
+    std::atomic<u32> busy{ 0 };
+    std::mutex mutex;
+    // Waiting for the counter to get to 0
+    std::vector<Job*> continuations;
+  };
+
+  // The function is stored inline, one allocation per job
+  struct Job
+  {
+    static constexpr size_t STORAGE_SIZE = 96;
+
+    void (*invoke)(Job& job){ nullptr };
+    void (*destroy)(Job& job){ nullptr };
+    JobCounter* counter{ nullptr };
+    JobAffinity affinity{ JobAffinity::ANY };
+    alignas(std::max_align_t) std::byte storage[STORAGE_SIZE];
+  };
+
+  struct JobSystemSettings
+  {
+    // Threads running jobs, the main thread included. 0 uses every hardware thread.
+    u32 worker_count{ 0 };
+    // Keep worker i on core i, so its deque and its jobs' data stay in that core's cache
+    bool pin_workers{ false };
+  };
+
+  struct JobWorkerStats
+  {
+    u64 executed{ 0 };
+    u64 stolen{ 0 };
+  };
+
+  // Work-stealing scheduler. Every worker has a Chase-Lev deque of its own: jobs it starts go to its
+  // bottom and it runs them newest first, idle workers steal from the top of the others'. Threads that
+  // aren't workers (the network sessions) submit to a shared queue instead.
+  //
+  // init() makes the calling thread worker 0, which is expected to be the main thread. Worker 0 only runs
+  // jobs while it waits with JobWait::HELP, the other workers sleep when there is nothing to run.
+  struct JobSystem
+  {
+    static constexpr u32 DEQUE_CAPACITY = 0x1000;
+    static constexpr u32 NOT_A_WORKER = 0xFFFF'FFFF;
+
+    static void init(const JobSystemSettings& settings);
+    // Runs whatever is still queued, then joins the workers
+    static void term();
+
+    static auto is_initialized() -> bool;
+    static auto get_worker_count() -> u32;
+    // NOT_A_WORKER on threads the job system didn't start, other than the one that called init()
+    static auto get_worker_index() -> u32;
+
+    template<typename F>
+    static void run(F&& function, JobCounter* counter = nullptr, JobAffinity affinity = JobAffinity::ANY)
+    {
+      schedule(make_job(std::forward<F>(function), counter, affinity));
+    }
+
+    // Starts the function once the dependency is done, counter tracks it from now already
+    template<typename F>
+    static void run_after(JobCounter& dependency, F&& function, JobCounter* counter = nullptr, JobAffinity affinity = JobAffinity::ANY)
+    {
+      schedule_after(dependency, make_job(std::forward<F>(function), counter, affinity));
+    }
+
+    // function(begin, end) for every batch_size items of [0, count), as a job each
+    template<typename F>
+    static void parallel_for(u32 count, u32 batch_size, const F& function, JobCounter& counter)
+    {
+      batch_size = std::max(batch_size, 1u);
+      for (u32 begin = 0; begin < count; begin += batch_size) {
+        u32 end = std::min(count, begin + batch_size);
+        run(
+            [function, begin, end]() {
+              function(begin, end);
+            },
+            &counter);
+      }
+    }
+
+    // Workers always help, a sleeping worker could be the one the counter is waiting for
+    static void wait(JobCounter& counter, JobWait mode = JobWait::HELP);
+    // Main thread only, the jobs started with JobAffinity::MAIN_THREAD
+    static void run_main_thread_jobs();
+
+    static auto get_stats() -> std::vector<JobWorkerStats>;
+
+  private:
+    template<typename F>
+    static auto make_job(F&& function, JobCounter* counter, JobAffinity affinity) -> Job*
+    {
+      using Function = std::decay_t<F>;
+      static_assert(sizeof(Function) <= Job::STORAGE_SIZE, "The job captures too much, capture a pointer to the data instead");
+      static_assert(alignof(Function) <= alignof(std::max_align_t), "The job's captures are over-aligned");
+
+      Job* job = new Job;
+      new (job->storage) Function(std::forward<F>(function));
+      job->invoke = [](Job& job) {
+        (*std::launder(reinterpret_cast<Function*>(job.storage)))();
+      };
+      job->destroy = [](Job& job) {
+        std::launder(reinterpret_cast<Function*>(job.storage))->~Function();
+      };
+      job->counter = counter;
+      job->affinity = affinity;
+
+      if (counter) {
+        counter->value.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      return job;
+    }
+
+    static void schedule(Job* job);
+    static void schedule_after(JobCounter& dependency, Job* job);
+    static void worker_loop(u32 index, bool pin);
+    static void execute(Job& job);
+    // Counts a job of the counter as done and starts what was waiting for it
+    static void finish(JobCounter& counter);
+  };
+
+} // namespace loki
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  // Chase-Lev deque of pointers, with the memory orderings of Lê et al., "Correct and Efficient Work-Stealing
+  // for Weak Memory Models". The owning thread pushes and pops at the bottom (LIFO, the freshest work is
+  // still in its cache), every other thread steals from the top (FIFO, the oldest and usually biggest work).
+  //
+  // Fixed capacity, push() fails instead of growing and the caller finds the item another home.
+  template<typename T, size_t CAPACITY>
+  class WorkStealingDeque
+  {
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "The capacity has to be a power of two");
+
+  public:
+    // Owner only
+    auto push(T* item) -> bool
+    {
+      i64 b = bottom.load(std::memory_order_relaxed);
+      i64 t = top.load(std::memory_order_acquire);
+      if (b - t >= static_cast<i64>(CAPACITY)) {
+        return false;
+      }
+
+      // Release on the slot too, a thief that reads it sees everything written to the item before the push
+      items[b & MASK].store(item, std::memory_order_release);
+      std::atomic_thread_fence(std::memory_order_release);
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return true;
+    }
+
+    // Owner only
+    auto pop() -> T*
+    {
+      i64 b = bottom.load(std::memory_order_relaxed) - 1;
+      bottom.store(b, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      i64 t = top.load(std::memory_order_relaxed);
+
+      if (t > b) {
+        // Empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+      }
+
+      T* item = items[b & MASK].load(std::memory_order_relaxed);
+      if (t == b) {
+        // The last item, a thief may be going for it too
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+          item = nullptr;
+        }
+
+        bottom.store(b + 1, std::memory_order_relaxed);
+      }
+
+      return item;
+    }
+
+    // Any thread. Null when empty or when another thread got the item first.
+    auto steal() -> T*
+    {
+      i64 t = top.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      i64 b = bottom.load(std::memory_order_acquire);
+
+      if (t >= b) {
+        return nullptr;
+      }
+
+      T* item = items[t & MASK].load(std::memory_order_acquire);
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+      }
+
+      return item;
+    }
+
+    // Only a hint unless called by the owner
+    auto is_empty() const -> bool
+    {
+      return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static constexpr i64 MASK = static_cast<i64>(CAPACITY) - 1;
+
+  private:
+    // Apart, so thieves bumping the top don't keep invalidating the owner's bottom
+    alignas(64) std::atomic<i64> top{ 0 };
+    alignas(64) std::atomic<i64> bottom{ 0 };
+    alignas(64) std::array<std::atomic<T*>, CAPACITY> items{};
+  };
+
+} // namespace loki
@@ -0,0 +1,19 @@
+#include "allocation_counter.h"
+
+namespace {
+
+  thread_local loki::u64 thread_allocation_count{ 0 };
+
+} // namespace
+
+auto
+loki::get_thread_allocation_count() -> loki::u64
+{
+  return thread_allocation_count;
+}
+
+void
+loki::count_allocation()
+{
+  ++thread_allocation_count;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  // Global operator new calls made by the calling thread since it started. Only counted in executables that
+  // replace new/delete with engine/memory/counting_new_delete.h, always 0 otherwise.
+  auto get_thread_allocation_count() -> u64;
+
+  // Called by the replaced operators
+  void count_allocation();
+
+} // namespace loki
@@ -0,0 +1,138 @@
+#include "buffer_pool.h"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace {
+
+  auto get_class(size_t capacity) -> size_t
+  {
+    return static_cast<size_t>(std::countr_zero(capacity / loki::BufferPool::MIN_SIZE));
+  }
+
+} // namespace
+
+loki::PooledBuffer::PooledBuffer(loki::PooledBuffer&& other) noexcept
+  : pool{ std::exchange(other.pool, nullptr) }
+  , data{ std::exchange(other.data, nullptr) }
+  , size{ std::exchange(other.size, 0) }
+  , capacity{ std::exchange(other.capacity, 0) }
+{
+}
+
+loki::PooledBuffer&
+loki::PooledBuffer::operator=(loki::PooledBuffer&& other) noexcept
+{
+  if (this != &other) {
+    release();
+    pool = std::exchange(other.pool, nullptr);
+    data = std::exchange(other.data, nullptr);
+    size = std::exchange(other.size, 0);
+    capacity = std::exchange(other.capacity, 0);
+  }
+
+  return *this;
+}
+
+loki::PooledBuffer::~PooledBuffer()
+{
+  release();
+}
+
+void
+loki::PooledBuffer::release()
+{
+  if (data) {
+    pool->release(data, capacity);
+  }
+
+  pool = nullptr;
+  data = nullptr;
+  size = 0;
+  capacity = 0;
+}
+
+void
+loki::PooledBuffer::discard()
+{
+  if (data) {
+    pool->discard(data, capacity);
+  }
+
+  pool = nullptr;
+  data = nullptr;
+  size = 0;
+  capacity = 0;
+}
+
+loki::BufferPool::BufferPool(size_t max_retained_bytes, loki::MemoryDomain domain)
+  : resource{ get_memory_resource(domain) }
+  , max_retained_bytes{ max_retained_bytes }
+{
+  static_assert(MIN_SIZE << (CLASS_COUNT - 1) == MAX_POOLED_SIZE, "Every pooled size needs a class");
+}
+
+loki::BufferPool::~BufferPool()
+{
+  for (size_t i = 0; i < CLASS_COUNT; ++i) {
+    for (std::byte* data : free_lists[i]) {
+      resource->deallocate(data, MIN_SIZE << i, ALIGNMENT);
+    }
+  }
+}
+
+auto
+loki::BufferPool::acquire(size_t size) -> loki::PooledBuffer
+{
+  if (size > MAX_POOLED_SIZE) {
+    std::lock_guard lock(mutex);
+    ++stats.acquired;
+    return { this, static_cast<std::byte*>(resource->allocate(size, ALIGNMENT)), size, size };
+  }
+
+  size_t capacity = std::bit_ceil(std::max(size, MIN_SIZE));
+  auto& free_list = free_lists[get_class(capacity)];
+
+  {
+    std::lock_guard lock(mutex);
+    ++stats.acquired;
+    if (!free_list.empty()) {
+      std::byte* data = free_list.back();
+      free_list.pop_back();
+      ++stats.reused;
+      stats.retained_bytes -= capacity;
+      return { this, data, size, capacity };
+    }
+  }
+
+  return { this, static_cast<std::byte*>(resource->allocate(capacity, ALIGNMENT)), size, capacity };
+}
+
+auto
+loki::BufferPool::get_stats() -> loki::BufferPoolStats
+{
+  std::lock_guard lock(mutex);
+  return stats;
+}
+
+void
+loki::BufferPool::release(std::byte* data, size_t capacity)
+{
+  if (capacity <= MAX_POOLED_SIZE) {
+    std::lock_guard lock(mutex);
+    if (stats.retained_bytes + capacity <= max_retained_bytes) {
+      free_lists[get_class(capacity)].push_back(data);
+      stats.retained_bytes += capacity;
+      return;
+    }
+  }
+
+  resource->deallocate(data, capacity, ALIGNMENT);
+}
+
+void
+loki::BufferPool::discard(std::byte* data, size_t capacity)
+{
+  resource->deallocate(data, capacity, ALIGNMENT);
+}
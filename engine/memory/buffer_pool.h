@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "engine/memory/memory_domain.h"
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  class BufferPool;
+
+  // A buffer on loan from a BufferPool, goes back to it when destroyed. It can't outlive the pool.
+  class PooledBuffer
+  {
+  public:
+    explicit PooledBuffer() = default;
+    PooledBuffer(PooledBuffer&& other) noexcept;
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+    ~PooledBuffer();
+
+  public:
+    void release();
+    // Freed instead of going back to the pool, for memory someone else accounts for
+    void discard();
+
+    auto get_span() const -> std::span<std::byte>
+    {
+      return { data, size };
+    }
+
+    auto get_capacity() const -> size_t
+    {
+      return capacity;
+    }
+
+  private:
+    friend class BufferPool;
+
+    PooledBuffer(BufferPool* pool, std::byte* data, size_t size, size_t capacity)
+      : pool{ pool }
+      , data{ data }
+      , size{ size }
+      , capacity{ capacity }
+    {
+    }
+
+  private:
+    BufferPool* pool{ nullptr };
+    std::byte* data{ nullptr };
+    size_t size{ 0 };
+    size_t capacity{ 0 };
+  };
+
+  struct BufferPoolStats
+  {
+    u64 acquired{ 0 };
+    // Acquired without allocating
+    u64 reused{ 0 };
+    u64 retained_bytes{ 0 };
+  };
+
+  // Recycles byte buffers in power of two size classes, for reads that want a fresh buffer every time.
+  // Up to max_retained_bytes of released buffers are kept, the rest is freed. Thread-safe.
+  class BufferPool
+  {
+  public:
+    static constexpr size_t MIN_SIZE = 0x1000;
+    // Bigger buffers are allocated and freed every time
+    static constexpr size_t MAX_POOLED_SIZE = 0x400'0000;
+
+  public:
+    explicit BufferPool(size_t max_retained_bytes, MemoryDomain domain = MemoryDomain::ASSETS);
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+    ~BufferPool();
+
+  public:
+    auto acquire(size_t size) -> PooledBuffer;
+    auto get_stats() -> BufferPoolStats;
+
+  private:
+    friend class PooledBuffer;
+
+    void release(std::byte* data, size_t capacity);
+    void discard(std::byte* data, size_t capacity);
+
+  private:
+    static constexpr size_t CLASS_COUNT = 15;
+    static constexpr size_t ALIGNMENT = 64;
+
+  private:
+    std::pmr::memory_resource* resource;
+    size_t max_retained_bytes;
+    std::mutex mutex;
+    std::array<std::vector<std::byte*>, CLASS_COUNT> free_lists;
+    BufferPoolStats stats;
+  };
+
+} // namespace loki
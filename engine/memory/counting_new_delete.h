@@ -0,0 +1,139 @@
+#pragma once
+
+// What mimalloc-new-delete.h does, plus a per-thread count of every allocation for
+// loki::get_thread_allocation_count(). Include it in exactly one source file of an executable, instead of
+// mimalloc-new-delete.h.
+
+#include <new>
+
+#include <mimalloc.h>
+
+#include "engine/memory/allocation_counter.h"
+
+void
+operator delete(void* pointer) noexcept
+{
+  mi_free(pointer);
+}
+
+void
+operator delete[](void* pointer) noexcept
+{
+  mi_free(pointer);
+}
+
+void
+operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+  mi_free(pointer);
+}
+
+void
+operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+  mi_free(pointer);
+}
+
+void
+operator delete(void* pointer, std::size_t size) noexcept
+{
+  mi_free_size(pointer, size);
+}
+
+void
+operator delete[](void* pointer, std::size_t size) noexcept
+{
+  mi_free_size(pointer, size);
+}
+
+void
+operator delete(void* pointer, std::align_val_t alignment) noexcept
+{
+  mi_free_aligned(pointer, static_cast<std::size_t>(alignment));
+}
+
+void
+operator delete[](void* pointer, std::align_val_t alignment) noexcept
+{
+  mi_free_aligned(pointer, static_cast<std::size_t>(alignment));
+}
+
+void
+operator delete(void* pointer, std::size_t size, std::align_val_t alignment) noexcept
+{
+  mi_free_size_aligned(pointer, size, static_cast<std::size_t>(alignment));
+}
+
+void
+operator delete[](void* pointer, std::size_t size, std::align_val_t alignment) noexcept
+{
+  mi_free_size_aligned(pointer, size, static_cast<std::size_t>(alignment));
+}
+
+void
+operator delete(void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  mi_free_aligned(pointer, static_cast<std::size_t>(alignment));
+}
+
+void
+operator delete[](void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  mi_free_aligned(pointer, static_cast<std::size_t>(alignment));
+}
+
+void*
+operator new(std::size_t size)
+{
+  loki::count_allocation();
+  return mi_new(size);
+}
+
+void*
+operator new[](std::size_t size)
+{
+  loki::count_allocation();
+  return mi_new(size);
+}
+
+void*
+operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  loki::count_allocation();
+  return mi_new_nothrow(size);
+}
+
+void*
+operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  loki::count_allocation();
+  return mi_new_nothrow(size);
+}
+
+void*
+operator new(std::size_t size, std::align_val_t alignment)
+{
+  loki::count_allocation();
+  return mi_new_aligned(size, static_cast<std::size_t>(alignment));
+}
+
+void*
+operator new[](std::size_t size, std::align_val_t alignment)
+{
+  loki::count_allocation();
+  return mi_new_aligned(size, static_cast<std::size_t>(alignment));
+}
+
+void*
+operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  loki::count_allocation();
+  return mi_new_aligned_nothrow(size, static_cast<std::size_t>(alignment));
+}
+
+void*
+operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  loki::count_allocation();
+  return mi_new_aligned_nothrow(size, static_cast<std::size_t>(alignment));
+}
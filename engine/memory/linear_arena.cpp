@@ -0,0 +1,81 @@
+#include "linear_arena.h"
+
+#include <algorithm>
+
+namespace {
+
+  // The block itself, allocations with a bigger alignment are aligned within it
+  constexpr size_t BLOCK_ALIGNMENT = 64;
+
+} // namespace
+
+loki::LinearArena::LinearArena(size_t capacity, std::pmr::memory_resource* upstream)
+  : upstream{ upstream }
+  , buffer{ static_cast<std::byte*>(upstream->allocate(capacity, BLOCK_ALIGNMENT)) }
+  , capacity{ capacity }
+  , overflow{ upstream }
+{
+}
+
+loki::LinearArena::~LinearArena()
+{
+  upstream->deallocate(buffer, capacity, BLOCK_ALIGNMENT);
+}
+
+void
+loki::LinearArena::reset()
+{
+  if (stats.overflows > 0) {
+    overflow.release();
+  }
+
+  cursor = 0;
+  stats.allocations = 0;
+  stats.used_bytes = 0;
+  stats.overflows = 0;
+}
+
+auto
+loki::LinearArena::do_allocate(size_t bytes, size_t alignment) -> void*
+{
+  ++stats.allocations;
+
+  auto base = reinterpret_cast<uintptr_t>(buffer);
+  uintptr_t start = (base + cursor + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+  size_t end = start - base + bytes;
+  if (end > capacity) {
+    ++stats.overflows;
+    stats.used_bytes += bytes;
+    stats.peak_bytes = std::max(stats.peak_bytes, stats.used_bytes);
+    return overflow.allocate(bytes, alignment);
+  }
+
+  stats.used_bytes += end - cursor;
+  stats.peak_bytes = std::max(stats.peak_bytes, stats.used_bytes);
+  cursor = end;
+  return buffer + (start - base);
+}
+
+void
+loki::LinearArena::do_deallocate(void*, size_t, size_t)
+{
+  // Everything goes at once in reset()
+}
+
+auto
+loki::LinearArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool
+{
+  return this == &other;
+}
+
+loki::FrameArena::FrameArena(size_t frame_capacity, std::pmr::memory_resource* upstream)
+  : arenas{ LinearArena{ frame_capacity, upstream }, LinearArena{ frame_capacity, upstream } }
+{
+}
+
+void
+loki::FrameArena::begin_frame()
+{
+  current = (current + 1) % FRAME_COUNT;
+  arenas[current].reset();
+}
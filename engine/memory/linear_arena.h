@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <format>
+#include <iterator>
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  struct ArenaStats
+  {
+    // Since the last reset
+    u32 allocations{ 0 };
+    u64 used_bytes{ 0 };
+    // Allocations that didn't fit and went to the upstream resource instead
+    u32 overflows{ 0 };
+    // Since construction
+    u64 peak_bytes{ 0 };
+  };
+
+  // Bump allocator over one block, everything is freed at once by reset() and deallocate is a no-op.
+  // The block comes from the upstream resource, and so does what doesn't fit. That is still released by
+  // reset(), so running out is slow, not fatal. Not thread-safe.
+  class LinearArena : public std::pmr::memory_resource
+  {
+  public:
+    explicit LinearArena(size_t capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+    ~LinearArena() override;
+
+  public:
+    void reset();
+
+    auto get_capacity() const -> size_t
+    {
+      return capacity;
+    }
+
+    auto get_stats() const -> const ArenaStats&
+    {
+      return stats;
+    }
+
+  private:
+    auto do_allocate(size_t bytes, size_t alignment) -> void* override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override;
+
+  private:
+    std::pmr::memory_resource* upstream;
+    std::byte* buffer{ nullptr };
+    size_t capacity{ 0 };
+    size_t cursor{ 0 };
+    std::pmr::monotonic_buffer_resource overflow;
+    ArenaStats stats;
+  };
+
+  // Transient data of one frame: a LinearArena per frame, reset when its frame comes around again. Two of
+  // them, so what the main thread allocated for frame N is still there while the render thread draws it
+  // and the main thread is already on frame N + 1. Main thread only.
+  class FrameArena
+  {
+  public:
+    static constexpr u32 FRAME_COUNT = 2;
+
+  public:
+    explicit FrameArena(size_t frame_capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+  public:
+    // Switches to the next arena and resets it, its frame has to be done on every thread
+    void begin_frame();
+
+    auto get_resource() -> std::pmr::memory_resource*
+    {
+      return &arenas[current];
+    }
+
+    auto get_stats() const -> const ArenaStats&
+    {
+      return arenas[current].get_stats();
+    }
+
+  private:
+    std::array<LinearArena, FRAME_COUNT> arenas;
+    u32 current{ 0 };
+  };
+
+  // std::format into a string allocated from resource
+  template<typename... Args>
+  auto pmr_format(std::pmr::memory_resource* resource, std::format_string<Args...> format, Args&&... args) -> std::pmr::string
+  {
+    std::pmr::string string{ resource };
+    std::format_to(std::back_inserter(string), format, std::forward<Args>(args)...);
+    return string;
+  }
+
+} // namespace loki
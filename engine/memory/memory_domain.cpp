@@ -0,0 +1,217 @@
+#include "memory_domain.h"
+
+#include <new>
+
+#include <mimalloc.h>
+
+#include "libassert/assert.hpp"
+
+namespace {
+
+  constexpr std::array<std::string_view, loki::MEMORY_DOMAIN_COUNT> DOMAIN_NAMES{ "Network", "Assets", "Strings", "Render", "Frame" };
+
+  // Apart, threads allocating in different domains don't fight over one cache line
+  struct alignas(64) DomainCounters
+  {
+    std::atomic<loki::u64> live_bytes{ 0 };
+    std::atomic<loki::u64> peak_bytes{ 0 };
+    std::atomic<loki::u64> allocations{ 0 };
+    std::atomic<loki::u64> allocated_bytes{ 0 };
+  };
+
+  std::array<DomainCounters, loki::MEMORY_DOMAIN_COUNT> counters;
+
+  void count_allocate(loki::MemoryDomain domain, size_t bytes)
+  {
+    auto& domain_counters = counters[static_cast<size_t>(domain)];
+    domain_counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    domain_counters.allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+    loki::u64 live = domain_counters.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    loki::u64 peak = domain_counters.peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !domain_counters.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+  }
+
+  void count_deallocate(loki::MemoryDomain domain, size_t bytes)
+  {
+    counters[static_cast<size_t>(domain)].live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  auto allocate_from(mi_heap_t* heap, size_t bytes, size_t alignment) -> void*
+  {
+    void* pointer = alignment <= alignof(std::max_align_t) ? mi_heap_malloc(heap, bytes) : mi_heap_malloc_aligned(heap, bytes, alignment);
+    if (!pointer) {
+      throw std::bad_alloc{};
+    }
+
+    return pointer;
+  }
+
+  // A heap can only be allocated from by the thread that created it, so every thread gets one per domain.
+  // Deleting them at thread exit hands the blocks still alive over to mimalloc's default heap.
+  struct ThreadHeaps
+  {
+    ~ThreadHeaps()
+    {
+      for (mi_heap_t* heap : heaps) {
+        if (heap) {
+          mi_heap_delete(heap);
+        }
+      }
+    }
+
+    auto get(loki::MemoryDomain domain) -> mi_heap_t*
+    {
+      mi_heap_t*& heap = heaps[static_cast<size_t>(domain)];
+      if (!heap) {
+        heap = mi_heap_new();
+      }
+
+      return heap;
+    }
+
+    std::array<mi_heap_t*, loki::MEMORY_DOMAIN_COUNT> heaps{};
+  };
+
+  thread_local ThreadHeaps thread_heaps;
+
+  class DomainResource : public std::pmr::memory_resource
+  {
+  public:
+    explicit DomainResource(loki::MemoryDomain domain)
+      : domain{ domain }
+    {
+    }
+
+  private:
+    auto do_allocate(size_t bytes, size_t alignment) -> void* override
+    {
+      void* pointer = allocate_from(thread_heaps.get(domain), bytes, alignment);
+      count_allocate(domain, bytes);
+      return pointer;
+    }
+
+    void do_deallocate(void* pointer, size_t bytes, size_t) override
+    {
+      // Whichever thread's heap it came from, mimalloc finds its page
+      mi_free(pointer);
+      count_deallocate(domain, bytes);
+    }
+
+    auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override
+    {
+      return this == &other;
+    }
+
+  private:
+    loki::MemoryDomain domain;
+  };
+
+} // namespace
+
+auto
+loki::get_domain_name(loki::MemoryDomain domain) -> std::string_view
+{
+  return DOMAIN_NAMES[static_cast<size_t>(domain)];
+}
+
+auto
+loki::get_memory_resource(loki::MemoryDomain domain) -> std::pmr::memory_resource*
+{
+  // Leaked on purpose, static objects destroyed after this one may still free into it
+  static auto* resources = new std::array<DomainResource, MEMORY_DOMAIN_COUNT>{
+    DomainResource{ MemoryDomain::NETWORK },
+    DomainResource{ MemoryDomain::ASSETS },
+    DomainResource{ MemoryDomain::STRINGS },
+    DomainResource{ MemoryDomain::RENDER },
+    DomainResource{ MemoryDomain::FRAME },
+  };
+
+  return &(*resources)[static_cast<size_t>(domain)];
+}
+
+auto
+loki::get_memory_snapshot() -> loki::MemorySnapshot
+{
+  MemorySnapshot snapshot;
+  snapshot.time = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < MEMORY_DOMAIN_COUNT; ++i) {
+    auto& stats = snapshot.domains[i];
+    stats.live_bytes = counters[i].live_bytes.load(std::memory_order_relaxed);
+    stats.peak_bytes = counters[i].peak_bytes.load(std::memory_order_relaxed);
+    stats.allocations = counters[i].allocations.load(std::memory_order_relaxed);
+    stats.allocated_bytes = counters[i].allocated_bytes.load(std::memory_order_relaxed);
+  }
+
+  size_t elapsed_ms = 0;
+  size_t user_ms = 0;
+  size_t system_ms = 0;
+  size_t resident = 0;
+  size_t peak_resident = 0;
+  size_t committed = 0;
+  size_t peak_committed = 0;
+  size_t page_faults = 0;
+  mi_process_info(&elapsed_ms, &user_ms, &system_ms, &resident, &peak_resident, &committed, &peak_committed, &page_faults);
+
+  snapshot.resident_bytes = resident;
+  snapshot.peak_resident_bytes = peak_resident;
+  snapshot.committed_bytes = committed;
+  return snapshot;
+}
+
+loki::MemoryHeap::MemoryHeap(loki::MemoryDomain domain)
+  : domain{ domain }
+  , heap{ mi_heap_new() }
+  , owner{ std::this_thread::get_id() }
+{
+}
+
+loki::MemoryHeap::~MemoryHeap()
+{
+  destroy();
+}
+
+void
+loki::MemoryHeap::destroy()
+{
+  if (!heap) {
+    return;
+  }
+
+  DEBUG_ASSERT(owner == std::this_thread::get_id(), "A memory heap can only be destroyed by the thread that created it");
+
+  mi_heap_destroy(heap);
+  heap = nullptr;
+  count_deallocate(domain, live_bytes.exchange(0, std::memory_order_relaxed));
+}
+
+auto
+loki::MemoryHeap::do_allocate(size_t bytes, size_t alignment) -> void*
+{
+  DEBUG_ASSERT(owner == std::this_thread::get_id(), "A memory heap can only be allocated from by the thread that created it");
+
+  if (!heap) {
+    heap = mi_heap_new();
+  }
+
+  void* pointer = allocate_from(heap, bytes, alignment);
+  live_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  count_allocate(domain, bytes);
+  return pointer;
+}
+
+void
+loki::MemoryHeap::do_deallocate(void* pointer, size_t bytes, size_t)
+{
+  mi_free(pointer);
+  live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+  count_deallocate(domain, bytes);
+}
+
+auto
+loki::MemoryHeap::do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool
+{
+  return this == &other;
+}
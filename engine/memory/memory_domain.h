@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory_resource>
+#include <string_view>
+#include <thread>
+
+#include "engine/utils/types.h"
+
+struct mi_heap_s;
+
+namespace loki {
+
+  // Who an allocation belongs to, for accounting. Each domain has mimalloc heaps of its own, so its memory
+  // isn't interleaved with everybody else's in the same pages.
+  enum class MemoryDomain : u8
+  {
+    NETWORK = 0,
+    ASSETS = 1,
+    STRINGS = 2,
+    RENDER = 3,
+    FRAME = 4,
+  };
+
+  constexpr size_t MEMORY_DOMAIN_COUNT = 5;
+
+  auto get_domain_name(MemoryDomain domain) -> std::string_view;
+
+  // Thread-safe, a thread allocates from a heap of the domain that belongs to that thread, a block can be
+  // freed on any thread. Never destroyed, so static objects can keep memory from it until the very end.
+  auto get_memory_resource(MemoryDomain domain) -> std::pmr::memory_resource*;
+
+  struct MemoryDomainStats
+  {
+    u64 live_bytes{ 0 };
+    u64 peak_bytes{ 0 };
+    // Since start, the rate is the difference between two snapshots
+    u64 allocations{ 0 };
+    u64 allocated_bytes{ 0 };
+  };
+
+  struct MemorySnapshot
+  {
+    std::chrono::steady_clock::time_point time;
+    std::array<MemoryDomainStats, MEMORY_DOMAIN_COUNT> domains;
+    // Of the whole process as mimalloc sees it, every allocation included
+    u64 resident_bytes{ 0 };
+    u64 peak_resident_bytes{ 0 };
+    u64 committed_bytes{ 0 };
+  };
+
+  // The counters are read one by one, the domains may be a few allocations apart from each other
+  auto get_memory_snapshot() -> MemorySnapshot;
+
+  // A mimalloc heap of its own, for memory that dies together (a session, a group of assets): destroy()
+  // frees every block still in it at once, without running any destructor. Only the thread that created
+  // it may allocate from it, blocks can be freed on any thread until it is destroyed.
+  class MemoryHeap : public std::pmr::memory_resource
+  {
+  public:
+    explicit MemoryHeap(MemoryDomain domain);
+    MemoryHeap(const MemoryHeap&) = delete;
+    MemoryHeap& operator=(const MemoryHeap&) = delete;
+    ~MemoryHeap() override;
+
+  public:
+    // Nothing allocated from the heap may be touched afterwards, allocating starts a new one
+    void destroy();
+
+    auto get_domain() const -> MemoryDomain
+    {
+      return domain;
+    }
+
+    auto get_live_bytes() const -> u64
+    {
+      return live_bytes.load(std::memory_order_relaxed);
+    }
+
+  private:
+    auto do_allocate(size_t bytes, size_t alignment) -> void* override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override;
+
+  private:
+    MemoryDomain domain;
+    mi_heap_s* heap{ nullptr };
+    std::thread::id owner;
+    std::atomic<u64> live_bytes{ 0 };
+  };
+
+} // namespace loki
@@ -0,0 +1,63 @@
+#include "memory_view.h"
+
+#include "imgui.h"
+
+namespace {
+
+  auto to_kib(loki::u64 bytes) -> double
+  {
+    return static_cast<double>(bytes) / 1'024.0;
+  }
+
+} // namespace
+
+void
+loki::MemoryView::draw()
+{
+  if (ImGui::Begin("Memory")) {
+    current = get_memory_snapshot();
+
+    double elapsed = std::chrono::duration<double>(current.time - previous.time).count();
+    if (elapsed >= RATE_INTERVAL) {
+      for (size_t i = 0; i < MEMORY_DOMAIN_COUNT; ++i) {
+        allocation_rates[i] = static_cast<double>(current.domains[i].allocations - previous.domains[i].allocations) / elapsed;
+        byte_rates[i] = static_cast<double>(current.domains[i].allocated_bytes - previous.domains[i].allocated_bytes) / elapsed;
+      }
+
+      previous = current;
+    }
+
+    ImGui::Text("Process: %.1f MiB resident, peak %.1f MiB, %.1f MiB committed", to_kib(current.resident_bytes) / 1'024.0, to_kib(current.peak_resident_bytes) / 1'024.0,
+        to_kib(current.committed_bytes) / 1'024.0);
+
+    if (ImGui::BeginTable("Domains", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+      ImGui::TableSetupColumn("Domain");
+      ImGui::TableSetupColumn("Live KiB");
+      ImGui::TableSetupColumn("Peak KiB");
+      ImGui::TableSetupColumn("Allocations/s");
+      ImGui::TableSetupColumn("KiB/s");
+      ImGui::TableHeadersRow();
+
+      for (size_t i = 0; i < MEMORY_DOMAIN_COUNT; ++i) {
+        const auto& stats = current.domains[i];
+        std::string_view name = get_domain_name(static_cast<MemoryDomain>(i));
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(name.data(), name.data() + name.size());
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", to_kib(stats.live_bytes));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", to_kib(stats.peak_bytes));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.0f", allocation_rates[i]);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", to_kib(static_cast<u64>(byte_rates[i])));
+      }
+
+      ImGui::EndTable();
+    }
+  }
+
+  ImGui::End();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+
+#include "engine/memory/memory_domain.h"
+
+namespace loki {
+
+  // ImGui "Memory" window: live and peak bytes and the allocation rate of every memory domain, and what
+  // the whole process uses. The rates are averaged over the last half second or so.
+  class MemoryView
+  {
+  public:
+    void draw();
+
+  private:
+    static constexpr double RATE_INTERVAL = 0.5;
+
+  private:
+    MemorySnapshot current;
+    MemorySnapshot previous;
+    std::array<double, MEMORY_DOMAIN_COUNT> allocation_rates{};
+    std::array<double, MEMORY_DOMAIN_COUNT> byte_rates{};
+  };
+
+} // namespace loki
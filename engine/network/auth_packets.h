@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "engine/crypto/srp_6.h"
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  struct PaketAuthChallengeRequest
+  {
+    u8 command{};
+    u8 protocol_version{};
+    u16 packet_size{};
+    std::array<u8, 4> game_name{};
+    u8 major_version{};
+    u8 minor_version{};
+    u8 patch_version{};
+    u16 build{};
+    std::array<u8, 4> platform{};
+    std::array<u8, 4> os{};
+    std::array<u8, 4> country{};
+    u32 timezone{};
+    u32 ip_address{};
+    std::vector<u8> login{};
+  };
+
+  struct PaketAuthChallengeResponse
+  {
+    u8 command{};
+    u8 protocol_version{};
+    u8 status{};
+    SRP6::EphemeralKey B{};
+    std::vector<u8> g{};
+    std::vector<u8> N{};
+    SRP6::EphemeralKey s{};
+    std::array<u8, 16> crc_salt{};
+    u8 two_factor_enabled{};
+  };
+
+  struct PaketAuthLogonProofRequest
+  {
+    u8 command{};
+    SRP6::EphemeralKey A{};
+    SHA1::Digest client_M{};
+    SHA1::Digest crc_hash{};
+    u8 number_of_keys{};
+    u8 two_factor_enabled{};
+  };
+
+  struct PaketAuthLogonProofResponse
+  {
+    u8 command{};
+    u8 status{};
+    SHA1::Digest server_M{};
+    u32 account_flags{};
+    u32 hardware_survey_id{};
+    u16 unknown_flags{};
+  };
+
+  struct PacketAuthRealmListRequest
+  {
+    u8 command{};
+    u32 unknown{};
+  };
+
+  struct PacketAuthRealmListHead
+  {
+    u8 command{};
+    u16 packet_size{};
+    u32 unknown{};
+    u16 number_of_realms{};
+  };
+
+} // namespace loki
@@ -1,73 +1,10 @@
 #include "auth_session.h"
 
+#include "auth_packets.h"
 #include "engine/config.h"
+#include "engine/time/profiler.h"
 #include "world_session.h"
 
-struct PaketAuthChallengeRequest
-{
-  loki::u8 command{};
-  loki::u8 protocol_version{};
-  loki::u16 packet_size{};
-  std::array<loki::u8, 4> game_name{};
-  loki::u8 major_version{};
-  loki::u8 minor_version{};
-  loki::u8 patch_version{};
-  loki::u16 build{};
-  std::array<loki::u8, 4> platform{};
-  std::array<loki::u8, 4> os{};
-  std::array<loki::u8, 4> country{};
-  loki::u32 timezone{};
-  loki::u32 ip_address{};
-  std::vector<loki::u8> login{};
-};
-
-struct PaketAuthChallengeResponse
-{
-  loki::u8 command{};
-  loki::u8 protocol_version{};
-  loki::u8 status{};
-  loki::SRP6::EphemeralKey B{};
-  std::vector<loki::u8> g{};
-  std::vector<loki::u8> N{};
-  loki::SRP6::EphemeralKey s{};
-  std::array<loki::u8, 16> crc_salt{};
-  loki::u8 two_factor_enabled{};
-};
-
-struct PaketAuthLogonProofRequest
-{
-  loki::u8 command{};
-  loki::SRP6::EphemeralKey A{};
-  loki::SHA1::Digest client_M{};
-  loki::SHA1::Digest crc_hash{};
-  loki::u8 number_of_keys{};
-  loki::u8 two_factor_enabled{};
-};
-
-struct PaketAuthLogonProofResponse
-{
-  loki::u8 command{};
-  loki::u8 status{};
-  loki::SHA1::Digest server_M{};
-  loki::u32 account_flags{};
-  loki::u32 hardware_survey_id{};
-  loki::u16 unknown_flags{};
-};
-
-struct PacketAuthRealmListRequest
-{
-  loki::u8 command{};
-  loki::u32 unknown{};
-};
-
-struct PacketAuthRealmListHead
-{
-  loki::u8 command{};
-  loki::u16 packet_size{};
-  loki::u32 unknown{};
-  loki::u16 number_of_realms{};
-};
-
 loki::AuthSession::AuthSession(std::string_view host, loki::u16 port)
   : connector({ std::string(host), port })
   , thread()
@@ -107,6 +44,8 @@ loki::AuthSession::handle_connection()
 {
   using namespace std::chrono_literals;
 
+  LOKI_PROFILE_THREAD("Auth");
+
   while (running) {
     switch (state) {
       case AuthSessionState::CHALLENGE:
@@ -149,6 +88,7 @@ loki::AuthSession::login(std::string_view username, std::string_view password)
 void
 loki::AuthSession::handle_challenge()
 {
+  LOKI_PROFILE_ZONE("Handle challenge");
   auto set_string = []<std::size_t N>(std::array<loki::u8, N>& data, const std::string& string) {
     DEBUG_ASSERT(string.size() <= N);
     std::reverse_copy(string.begin(), string.end(), data.begin());
@@ -196,6 +136,7 @@ loki::AuthSession::handle_challenge()
 void
 loki::AuthSession::handle_logon_proof()
 {
+  LOKI_PROFILE_ZONE("Handle logon proof");
   {
     PaketAuthLogonProofRequest pkt;
     pkt.command = 0x1;
@@ -223,6 +164,7 @@ loki::AuthSession::handle_logon_proof()
 void
 loki::AuthSession::handle_realm_list()
 {
+  LOKI_PROFILE_ZONE("Handle realm list");
   spdlog::info("Checking ream list...");
 
   PacketAuthRealmListRequest pkt;
@@ -256,6 +198,13 @@ loki::AuthSession::get_realms() const -> std::vector<PacketAuthRealm>
   return realms;
 }
 
+auto
+loki::AuthSession::get_realms(std::pmr::memory_resource* resource) const -> std::pmr::vector<PacketAuthRealm>
+{
+  std::shared_lock lock(realms_mutex);
+  return { realms.begin(), realms.end(), resource };
+}
+
 auto
 loki::AuthSession::get_username() const -> const std::string&
 {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <memory_resource>
 #include <queue>
 #include <shared_mutex>
 #include <thread>
@@ -50,6 +51,8 @@ namespace loki {
     void stop();
     void shutdown();
     auto get_realms() const -> std::vector<PacketAuthRealm>;
+    // Copied into the given resource, a frame arena for a UI that shows them every frame
+    auto get_realms(std::pmr::memory_resource* resource) const -> std::pmr::vector<PacketAuthRealm>;
     auto get_username() const -> const std::string&;
     auto get_session_key() const -> std::optional<SessionKey>;
 
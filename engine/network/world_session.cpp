@@ -3,6 +3,7 @@
 #include "engine/config.h"
 #include "engine/crypto/crypto_hash.h"
 #include "engine/crypto/crypto_random.h"
+#include "engine/time/profiler.h"
 #include "opcodes.h"
 
 loki::WorldSession::WorldSession(const std::weak_ptr<AuthSession>& auth_session, u8 realm_id, std::string_view host, loki::u16 port)
@@ -32,6 +33,7 @@ loki::WorldSession::~WorldSession()
 void
 loki::WorldSession::handle_connection()
 {
+  LOKI_PROFILE_THREAD("World");
   spdlog::info("Connected to {}", socket.peer_address().to_string());
 
   const auto& session_key = auth_session.lock()->get_session_key();
@@ -84,6 +86,7 @@ loki::WorldSession::read_next_packet()
 void
 loki::WorldSession::process_command(loki::u16 command)
 {
+  LOKI_PROFILE_ZONE("Process command");
   switch (command) {
     case SMSG_AUTH_CHALLENGE:
       handle_auth_challenge();
@@ -100,6 +103,7 @@ loki::WorldSession::process_command(loki::u16 command)
 void
 loki::WorldSession::handle_auth_challenge()
 {
+  LOKI_PROFILE_ZONE("Handle auth challenge");
   spdlog::info("Receiving SMSG_AUTH_CHALLENGE");
 
   auto one = buffer.read<u32>();
@@ -151,6 +155,7 @@ loki::WorldSession::handle_auth_challenge()
 void
 loki::WorldSession::handle_auth_response()
 {
+  LOKI_PROFILE_ZONE("Handle auth response");
   spdlog::info("Receiving SMSG_AUTH_RESPONSE");
 
   u8 status = buffer.read<u8>();
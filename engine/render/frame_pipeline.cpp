@@ -0,0 +1,100 @@
+#include "frame_pipeline.h"
+
+#include "engine/time/profiler.h"
+
+loki::GuiSnapshot::~GuiSnapshot()
+{
+  clear();
+}
+
+void
+loki::GuiSnapshot::capture(const ImDrawData& source)
+{
+  clear();
+
+  draw_data.Valid = source.Valid;
+  draw_data.TotalIdxCount = source.TotalIdxCount;
+  draw_data.TotalVtxCount = source.TotalVtxCount;
+  draw_data.DisplayPos = source.DisplayPos;
+  draw_data.DisplaySize = source.DisplaySize;
+  draw_data.FramebufferScale = source.FramebufferScale;
+
+  // Only the command, index and vertex buffers are copied, which is all a renderer backend reads
+  for (ImDrawList* list : source.CmdLists) {
+    draw_data.CmdLists.push_back(list->CloneOutput());
+  }
+
+  draw_data.CmdListsCount = draw_data.CmdLists.Size;
+}
+
+void
+loki::GuiSnapshot::clear()
+{
+  for (ImDrawList* list : draw_data.CmdLists) {
+    IM_DELETE(list);
+  }
+
+  draw_data.Clear();
+}
+
+auto
+loki::FramePipeline::acquire() -> loki::FramePacket&
+{
+  LOKI_PROFILE_ZONE("Wait for render thread");
+  std::unique_lock lock(mutex);
+  condition.wait(lock, [this]() {
+    return published - released < PACKET_COUNT;
+  });
+
+  return packets[published % PACKET_COUNT];
+}
+
+void
+loki::FramePipeline::publish()
+{
+  {
+    std::lock_guard lock(mutex);
+    ++published;
+  }
+
+  condition.notify_all();
+}
+
+auto
+loki::FramePipeline::consume() -> loki::FramePacket*
+{
+  LOKI_PROFILE_ZONE("Wait for frame");
+  std::unique_lock lock(mutex);
+  condition.wait(lock, [this]() {
+    return consumed < published || stopping;
+  });
+
+  // Frames published before stop() are still drawn, the last one shouldn't just vanish
+  if (consumed == published) {
+    return nullptr;
+  }
+
+  return &packets[consumed++ % PACKET_COUNT];
+}
+
+void
+loki::FramePipeline::release()
+{
+  {
+    std::lock_guard lock(mutex);
+    ++released;
+  }
+
+  condition.notify_all();
+}
+
+void
+loki::FramePipeline::stop()
+{
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+
+  condition.notify_all();
+}
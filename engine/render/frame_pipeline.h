@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "engine/render/gpu_timer.h"
+#include "engine/render/render_queue.h"
+#include "engine/render/stream_buffer.h"
+#include "engine/utils/types.h"
+#include "imgui.h"
+
+namespace loki {
+
+  // Deep copy of ImGui's draw data. The draw lists are owned by ImGui and rewritten by the next
+  // ImGui::NewFrame(), a frame rendered on another thread has to keep its own.
+  class GuiSnapshot
+  {
+  public:
+    GuiSnapshot() = default;
+    GuiSnapshot(const GuiSnapshot&) = delete;
+    GuiSnapshot& operator=(const GuiSnapshot&) = delete;
+    ~GuiSnapshot();
+
+  public:
+    void capture(const ImDrawData& source);
+    void clear();
+
+    auto get_draw_data() -> ImDrawData*
+    {
+      return &draw_data;
+    }
+
+  private:
+    ImDrawData draw_data;
+  };
+
+  // Everything the render thread needs for one frame, written by the main thread and read-only once published
+  struct FramePacket
+  {
+    RenderQueue queue;
+    GuiSnapshot gui;
+    // Filled in by the render thread, the main thread reads them back when it gets the packet again
+    double render_thread_ms{ 0.0 };
+    StreamStats stream_stats;
+    std::vector<GpuTiming> gpu_timings;
+  };
+
+  // Two packets handed back and forth between the main thread and the render thread: the main thread
+  // builds frame N while the render thread draws frame N-1, and neither gets further ahead than that.
+  class FramePipeline
+  {
+  public:
+    static constexpr size_t PACKET_COUNT = 2;
+
+  public:
+    // Main thread. Waits until the render thread is done with the packet from two frames ago.
+    auto acquire() -> FramePacket&;
+    void publish();
+
+    // Render thread. Null once stopped and everything published has been drawn.
+    auto consume() -> FramePacket*;
+    void release();
+
+    void stop();
+
+  private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::array<FramePacket, PACKET_COUNT> packets;
+    u64 published{ 0 };
+    u64 consumed{ 0 };
+    u64 released{ 0 };
+    bool stopping{ false };
+  };
+
+} // namespace loki
@@ -0,0 +1,156 @@
+#include "gpu_timer.h"
+
+#include <limits>
+
+#include "spdlog/spdlog.h"
+
+namespace {
+
+  constexpr loki::u32 NO_ZONE = std::numeric_limits<loki::u32>::max();
+
+} // namespace
+
+loki::GpuTimerPool::~GpuTimerPool()
+{
+  term();
+}
+
+auto
+loki::GpuTimerPool::init() -> bool
+{
+  if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query) {
+    spdlog::warn("Timer queries aren't supported, no GPU timings");
+    return false;
+  }
+
+  // Allowed by the spec, and then the timestamps are useless
+  GLint counter_bits = 0;
+  glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &counter_bits);
+  if (counter_bits == 0) {
+    spdlog::warn("The GPU timestamp counter has 0 bits, no GPU timings");
+    return false;
+  }
+
+  for (auto& frame : frames) {
+    glGenQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+    frame.zones.reserve(MAX_ZONES);
+  }
+
+  open_zones.reserve(MAX_ZONES);
+  timings.reserve(MAX_ZONES);
+  supported = true;
+  return true;
+}
+
+void
+loki::GpuTimerPool::term()
+{
+  if (!supported) {
+    return;
+  }
+
+  for (auto& frame : frames) {
+    glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+    frame.queries.fill(0);
+    frame.zones.clear();
+  }
+
+  supported = false;
+  in_frame = false;
+}
+
+void
+loki::GpuTimerPool::begin_frame()
+{
+  if (!supported) {
+    return;
+  }
+
+  FrameQueries& frame = frames[frame_index % FRAME_COUNT];
+  if (!frame.zones.empty()) {
+    resolve(frame);
+    frame.zones.clear();
+  }
+
+  open_zones.clear();
+  in_frame = true;
+  begin_zone("GPU frame");
+}
+
+void
+loki::GpuTimerPool::end_frame()
+{
+  if (!in_frame) {
+    return;
+  }
+
+  // The frame zone is the last one open, so its end is the last query of the frame
+  while (!open_zones.empty()) {
+    end_zone();
+  }
+
+  in_frame = false;
+  ++frame_index;
+}
+
+void
+loki::GpuTimerPool::begin_zone(const char* name)
+{
+  if (!in_frame) {
+    return;
+  }
+
+  FrameQueries& frame = frames[frame_index % FRAME_COUNT];
+  if (frame.zones.size() == MAX_ZONES) {
+    open_zones.push_back(NO_ZONE);
+    return;
+  }
+
+  auto index = static_cast<u32>(frame.zones.size());
+  frame.zones.push_back({ name, static_cast<u32>(open_zones.size()) });
+  glQueryCounter(frame.queries[index * 2], GL_TIMESTAMP);
+  open_zones.push_back(index);
+}
+
+void
+loki::GpuTimerPool::end_zone()
+{
+  if (!in_frame || open_zones.empty()) {
+    return;
+  }
+
+  u32 index = open_zones.back();
+  open_zones.pop_back();
+
+  if (index != NO_ZONE) {
+    glQueryCounter(frames[frame_index % FRAME_COUNT].queries[index * 2 + 1], GL_TIMESTAMP);
+  }
+}
+
+void
+loki::GpuTimerPool::resolve(const loki::GpuTimerPool::FrameQueries& frame)
+{
+  // Queries finish in the order they were issued, the frame's end being there means all of them are
+  GLint available = GL_FALSE;
+  glGetQueryObjectiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) {
+    ++dropped_frames;
+    return;
+  }
+
+  timings.clear();
+
+  GLuint64 frame_start = 0;
+  for (size_t i = 0; i < frame.zones.size(); ++i) {
+    GLuint64 start = 0;
+    GLuint64 end = 0;
+    glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+    if (i == 0) {
+      frame_start = start;
+    }
+
+    timings.push_back({ frame.zones[i].name, frame.zones[i].depth, start - frame_start, end > start ? end - start : 0 });
+  }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <array>
+#include <vector>
+
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  struct GpuTiming
+  {
+    // Zone names are string literals, like the CPU profiler's
+    const char* name{ nullptr };
+    u32 depth{ 0 };
+    // From the start of the frame's first zone
+    u64 start_ns{ 0 };
+    u64 duration_ns{ 0 };
+  };
+
+  // GL_TIMESTAMP queries around the GPU work of a frame. Timestamps rather than GL_TIME_ELAPSED because
+  // elapsed queries can't nest, and a pass inside the frame zone is exactly that.
+  //
+  // Every frame in flight has a set of queries of its own, a set is only read back when its frame comes
+  // around again, FRAME_COUNT frames later. If the GPU still hasn't finished it by then the frame is
+  // dropped rather than waited for, readback never stalls. Without timer queries (GL < 3.3 and no
+  // ARB_timer_query, or a driver with a 0-bit counter) init() fails and every other call does nothing.
+  class GpuTimerPool
+  {
+  public:
+    static constexpr u32 FRAME_COUNT = 2;
+    // Per frame, zones past it aren't timed
+    static constexpr u32 MAX_ZONES = 64;
+
+  public:
+    GpuTimerPool() = default;
+    GpuTimerPool(const GpuTimerPool&) = delete;
+    GpuTimerPool& operator=(const GpuTimerPool&) = delete;
+    ~GpuTimerPool();
+
+  public:
+    auto init() -> bool;
+    void term();
+
+    // Reads back the frame from FRAME_COUNT frames ago and opens the "GPU frame" zone
+    void begin_frame();
+    void end_frame();
+
+    void begin_zone(const char* name);
+    void end_zone();
+
+    auto is_supported() const -> bool
+    {
+      return supported;
+    }
+
+    // Of the newest frame read back, the first one is the whole frame
+    auto get_timings() const -> const std::vector<GpuTiming>&
+    {
+      return timings;
+    }
+
+    // Frames the GPU hadn't finished by the time their queries were due again
+    auto get_dropped_frames() const -> u32
+    {
+      return dropped_frames;
+    }
+
+  private:
+    struct Zone
+    {
+      const char* name{ nullptr };
+      u32 depth{ 0 };
+    };
+
+    // Zone i is timed by queries 2i (begin) and 2i + 1 (end)
+    struct FrameQueries
+    {
+      std::array<GLuint, MAX_ZONES * 2> queries{};
+      std::vector<Zone> zones;
+    };
+
+  private:
+    void resolve(const FrameQueries& frame);
+
+  private:
+    bool supported{ false };
+    bool in_frame{ false };
+    u32 frame_index{ 0 };
+    std::array<FrameQueries, FRAME_COUNT> frames;
+    // Zone indices, or NO_ZONE for the ones that didn't fit
+    std::vector<u32> open_zones;
+    std::vector<GpuTiming> timings;
+    u32 dropped_frames{ 0 };
+  };
+
+  class GpuTimerScope
+  {
+  public:
+    GpuTimerScope(GpuTimerPool& pool, const char* name)
+      : pool{ pool }
+    {
+      pool.begin_zone(name);
+    }
+
+    GpuTimerScope(const GpuTimerScope&) = delete;
+    GpuTimerScope& operator=(const GpuTimerScope&) = delete;
+
+    ~GpuTimerScope()
+    {
+      pool.end_zone();
+    }
+
+  private:
+    GpuTimerPool& pool;
+  };
+
+} // namespace loki
@@ -0,0 +1,203 @@
+#include "headless_context.h"
+
+#ifdef LOKI_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "spdlog/spdlog.h"
+
+loki::HeadlessContext::~HeadlessContext()
+{
+  destroy();
+}
+
+auto
+loki::HeadlessContext::create(loki::i32 _width, loki::i32 _height) -> bool
+{
+  width = _width;
+  height = _height;
+
+  if (!create_surfaceless() && !create_hidden_window()) {
+    spdlog::error("Failed to create a headless GL context!");
+    return false;
+  }
+
+  spdlog::info("Headless GL context: {}, {}", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+  return create_framebuffer();
+}
+
+void
+loki::HeadlessContext::destroy()
+{
+  if (framebuffer) {
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &color_buffer);
+    glDeleteRenderbuffers(1, &depth_buffer);
+    framebuffer = color_buffer = depth_buffer = 0;
+  }
+
+#ifdef LOKI_HAS_EGL
+  if (egl_display) {
+    eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (egl_context) {
+      eglDestroyContext(egl_display, egl_context);
+    }
+
+    eglTerminate(egl_display);
+    egl_display = egl_context = nullptr;
+  }
+#endif
+
+  if (window) {
+    glfwDestroyWindow(window);
+    window = nullptr;
+  }
+}
+
+void
+loki::HeadlessContext::bind_framebuffer() const
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void
+loki::HeadlessContext::make_current() const
+{
+#ifdef LOKI_HAS_EGL
+  if (egl_context) {
+    eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context);
+    return;
+  }
+#endif
+
+  glfwMakeContextCurrent(window);
+}
+
+void
+loki::HeadlessContext::release_current() const
+{
+#ifdef LOKI_HAS_EGL
+  if (egl_context) {
+    eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    return;
+  }
+#endif
+
+  glfwMakeContextCurrent(nullptr);
+}
+
+auto
+loki::HeadlessContext::create_surfaceless() -> bool
+{
+#ifdef LOKI_HAS_EGL
+  auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+  if (!get_platform_display) {
+    spdlog::warn("EGL has no eglGetPlatformDisplayEXT, falling back to a hidden window");
+    return false;
+  }
+
+  EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+  EGLint major = 0, minor = 0;
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+    spdlog::warn("No surfaceless EGL display (error {:#x}), falling back to a hidden window", eglGetError());
+    return false;
+  }
+
+  egl_display = display;
+
+  // No surface type bits, the context is only ever made current without a surface
+  const EGLint config_attributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_SURFACE_TYPE, 0, EGL_NONE };
+
+  EGLConfig config = nullptr;
+  EGLint config_count = 0;
+  eglChooseConfig(display, config_attributes, &config, 1, &config_count);
+
+  // Same version and profile as the windowed context, so shaders behave the same in both
+  const EGLint context_attributes[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3, EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE,
+  };
+
+  eglBindAPI(EGL_OPENGL_API);
+  egl_context = eglCreateContext(display, config_count ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attributes);
+  if (!egl_context || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context)) {
+    spdlog::warn("Failed to create a surfaceless EGL context (error {:#x}), falling back to a hidden window", eglGetError());
+    destroy();
+    return false;
+  }
+
+  // glewInit() would also look for a GLX display and fail without one, the GL part is all we need
+  if (glewContextInit()) {
+    spdlog::error("Failed to initialize GLEW for the surfaceless context!");
+    destroy();
+    return false;
+  }
+
+  spdlog::info("Surfaceless EGL {}.{} context created", major, minor);
+  return true;
+#else
+  return false;
+#endif
+}
+
+auto
+loki::HeadlessContext::create_hidden_window() -> bool
+{
+  if (!glfwInit()) {
+    spdlog::error("Failed to initialize GLFW!");
+    return false;
+  }
+
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+  // The window is never shown, its size doesn't matter, the offscreen framebuffer has the real one
+  window = glfwCreateWindow(64, 64, "Loki Engine (headless)", nullptr, nullptr);
+  if (!window) {
+    spdlog::error("Failed to create a hidden GLFW window!");
+    return false;
+  }
+
+  glfwMakeContextCurrent(window);
+  glfwSwapInterval(0);
+
+  if (glewInit()) {
+    spdlog::error("Failed to initialize GLEW!");
+    destroy();
+    return false;
+  }
+
+  return true;
+}
+
+auto
+loki::HeadlessContext::create_framebuffer() -> bool
+{
+  glGenRenderbuffers(1, &color_buffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, color_buffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+  glGenRenderbuffers(1, &depth_buffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_buffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_buffer);
+
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    spdlog::error("Offscreen framebuffer is incomplete: {:#x}", status);
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  // GL context for machines without a display or a GPU. Built with EGL it's a surfaceless context
+  // (Mesa llvmpipe is enough), otherwise, or when that fails, a hidden GLFW window. Either way there is
+  // nothing to present to, frames are rendered into an offscreen framebuffer of the requested size.
+  class HeadlessContext
+  {
+  public:
+    HeadlessContext() = default;
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+    ~HeadlessContext();
+
+  public:
+    // Makes the context current and loads the GL entry points
+    auto create(i32 width, i32 height) -> bool;
+    void destroy();
+
+    void bind_framebuffer() const;
+
+    // The context is current on one thread at a time, a render thread takes it over with these
+    void make_current() const;
+    void release_current() const;
+
+    // Null for the surfaceless context
+    auto get_window() const -> GLFWwindow*
+    {
+      return window;
+    }
+
+  private:
+    auto create_surfaceless() -> bool;
+    auto create_hidden_window() -> bool;
+    auto create_framebuffer() -> bool;
+
+  private:
+    GLFWwindow* window{ nullptr };
+    // EGLDisplay and EGLContext, kept opaque so the EGL headers stay out of here
+    void* egl_display{ nullptr };
+    void* egl_context{ nullptr };
+    u32 framebuffer{ 0 };
+    u32 color_buffer{ 0 };
+    u32 depth_buffer{ 0 };
+    i32 width{ 0 };
+    i32 height{ 0 };
+  };
+
+} // namespace loki
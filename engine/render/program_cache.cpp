@@ -0,0 +1,180 @@
+#include "program_cache.h"
+
+#include <GL/glew.h>
+
+#include <format>
+#include <fstream>
+#include <memory_resource>
+#include <vector>
+
+#include "engine/memory/memory_domain.h"
+#include "spdlog/spdlog.h"
+
+namespace {
+
+  constexpr uint32_t CACHE_MAGIC = 0x42'50'4B'4C; // "LKPB"
+  constexpr uint32_t CACHE_VERSION = 1;
+
+  struct CacheHeader
+  {
+    uint32_t magic{ CACHE_MAGIC };
+    uint32_t version{ CACHE_VERSION };
+    loki::ProgramBinaryCache::Key key{};
+    uint32_t binary_format{ 0 };
+    uint32_t binary_length{ 0 };
+  };
+
+  std::filesystem::path cache_directory;
+
+  auto get_driver_string(GLenum name) -> std::string_view
+  {
+    const auto* string = reinterpret_cast<const char*>(glGetString(name));
+    return string ? string : "";
+  }
+
+  auto get_entry_path(const loki::ProgramBinaryCache::Key& key) -> std::filesystem::path
+  {
+    std::string name;
+    for (loki::u8 byte : key) {
+      name += std::format("{:02x}", byte);
+    }
+
+    return cache_directory / (name + ".bin");
+  }
+
+} // namespace
+
+void
+loki::ProgramBinaryCache::set_directory(const std::filesystem::path& path)
+{
+  std::error_code error;
+  std::filesystem::create_directories(path, error);
+  if (error) {
+    spdlog::warn("Shader cache is disabled, can't create {}: {}", path.string(), error.message());
+    cache_directory.clear();
+    return;
+  }
+
+  cache_directory = path;
+}
+
+auto
+loki::ProgramBinaryCache::is_enabled() -> bool
+{
+  if (cache_directory.empty() || !GLEW_ARB_get_program_binary) {
+    return false;
+  }
+
+  // Some drivers expose the extension but no formats, in which case nothing can be retrieved
+  GLint formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  return formats > 0;
+}
+
+auto
+loki::ProgramBinaryCache::make_key(const loki::ProgramSource& source) -> Key
+{
+  crypto::SHA1 hash;
+  hash.update_data(get_driver_string(GL_VENDOR));
+  hash.update_data(get_driver_string(GL_RENDERER));
+  hash.update_data(get_driver_string(GL_VERSION));
+  hash.update_data(get_driver_string(GL_SHADING_LANGUAGE_VERSION));
+
+  // Length prefixes keep "ab" + "c" and "a" + "bc" apart
+  for (const std::string* string : { &source.vert, &source.frag }) {
+    std::array<u8, sizeof(u64)> length{};
+    for (size_t i = 0; i < length.size(); ++i) {
+      length[i] = static_cast<u8>(static_cast<u64>(string->size()) >> (8 * i));
+    }
+    hash.update_data(length);
+    hash.update_data(*string);
+  }
+
+  hash.finalize();
+  return hash.get_digest();
+}
+
+auto
+loki::ProgramBinaryCache::load(const Key& key, uint32_t program_id) -> bool
+{
+  auto path = get_entry_path(key);
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  CacheHeader header;
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+  std::pmr::vector<char> binary{ get_memory_resource(MemoryDomain::ASSETS) };
+  if (file && header.magic == CACHE_MAGIC && header.version == CACHE_VERSION && header.key == key) {
+    binary.resize(header.binary_length);
+    file.read(binary.data(), (std::streamsize)binary.size());
+  }
+  file.close();
+
+  if (binary.empty() || binary.size() != header.binary_length) {
+    spdlog::warn("Dropping corrupted shader cache entry {}", path.filename().string());
+    // Not being able to is no reason to fail the program, it's only dropped again next time
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    return false;
+  }
+
+  glProgramBinary(program_id, header.binary_format, binary.data(), (GLsizei)binary.size());
+
+  // Drivers are free to reject binaries (e.g. after an update with the same version string)
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program_id, GL_LINK_STATUS, &linked);
+  if (!linked) {
+    spdlog::info("Driver rejected shader cache entry {}, relinking from source", path.filename().string());
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    return false;
+  }
+
+  return true;
+}
+
+void
+loki::ProgramBinaryCache::store(const Key& key, uint32_t program_id)
+{
+  GLint length = 0;
+  glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+
+  CacheHeader header;
+  header.key = key;
+
+  std::pmr::vector<char> binary(length, get_memory_resource(MemoryDomain::ASSETS));
+  GLsizei written = 0;
+  GLenum format = 0;
+  glGetProgramBinary(program_id, length, &written, &format, binary.data());
+  header.binary_format = format;
+  header.binary_length = (uint32_t)written;
+
+  // Write to a temporary file first, a crash mid-write must not leave a truncated entry behind
+  auto path = get_entry_path(key);
+  auto temp_path = path;
+  temp_path += ".tmp";
+
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), written);
+    if (!file) {
+      spdlog::warn("Failed to write shader cache entry {}", path.filename().string());
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temp_path, path, error);
+  if (error) {
+    spdlog::warn("Failed to store shader cache entry {}: {}", path.filename().string(), error.message());
+    std::filesystem::remove(temp_path, error);
+  }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "engine/crypto/crypto_hash.h"
+
+namespace loki {
+
+  struct ProgramSource
+  {
+    std::string vert;
+    std::string frag;
+  };
+
+  // glGetProgramBinary/glProgramBinary cache on disk. Entries are keyed by the program sources and the
+  // driver identification strings, so a driver update simply misses instead of feeding a stale binary.
+  class ProgramBinaryCache
+  {
+  public:
+    using Key = crypto::SHA1::Digest;
+
+    static void set_directory(const std::filesystem::path& path);
+    static auto is_enabled() -> bool;
+
+    static auto make_key(const ProgramSource& source) -> Key;
+
+    // False when there is no entry or the driver rejected it, the program must be linked from source then
+    static auto load(const Key& key, uint32_t program_id) -> bool;
+    static void store(const Key& key, uint32_t program_id);
+  };
+
+} // namespace loki
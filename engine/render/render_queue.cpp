@@ -0,0 +1,335 @@
+#include "render_queue.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+  constexpr loki::u32 DEPTH_BITS = 24;
+  constexpr loki::u32 DEPTH_MAX = (1u << DEPTH_BITS) - 1;
+  constexpr loki::u32 UNBOUND = 0xFFFF'FFFF;
+
+  // std140 layouts of the engine's uniform blocks
+  struct CameraBlock
+  {
+    glm::mat4 view;
+    glm::mat4 projection;
+  };
+
+  struct DrawBlock
+  {
+    glm::mat4 model;
+  };
+
+  auto has_block(loki::ProgramHandle program, loki::UniformBlock block) -> bool
+  {
+    const loki::UniformTable* table = loki::ShaderManager::get_uniform_table(program);
+    return table && table->has_block(block);
+  }
+
+  auto quantize_depth(float depth) -> loki::u64
+  {
+    return static_cast<loki::u64>(std::clamp(depth, 0.f, 1.f) * static_cast<float>(DEPTH_MAX));
+  }
+
+  auto get_pass(loki::u64 key) -> loki::RenderPass
+  {
+    return static_cast<loki::RenderPass>(key >> 56);
+  }
+
+  auto get_pass_name(loki::RenderPass pass) -> const char*
+  {
+    switch (pass) {
+      case loki::RenderPass::OPAQUE:
+        return "Opaque";
+      case loki::RenderPass::SKYBOX:
+        return "Skybox";
+      case loki::RenderPass::TRANSPARENT:
+        return "Transparent";
+      case loki::RenderPass::OVERLAY:
+        return "Overlay";
+    }
+
+    return "Unknown pass";
+  }
+
+  auto get_index_size(loki::u32 index_type) -> loki::u32
+  {
+    switch (index_type) {
+      case GL_UNSIGNED_BYTE:
+        return 1;
+      case GL_UNSIGNED_SHORT:
+        return 2;
+      default:
+        return 4;
+    }
+  }
+
+} // namespace
+
+auto
+loki::RenderQueue::make_key(loki::RenderPass pass, loki::ProgramHandle program, loki::u16 material, float depth) -> loki::u64
+{
+  u64 key = static_cast<u64>(pass) << 56;
+  u64 program_bits = program.get_id() & 0xFFFF;
+
+  if (pass == RenderPass::TRANSPARENT) {
+    key |= (DEPTH_MAX - quantize_depth(depth)) << 32;
+    key |= program_bits << 16;
+    key |= material;
+  } else {
+    key |= program_bits << 40;
+    key |= static_cast<u64>(material) << 24;
+    key |= quantize_depth(depth);
+  }
+
+  return key;
+}
+
+void
+loki::RenderQueue::reset()
+{
+  entries.clear();
+  commands.clear();
+  draw_blocks.clear();
+  camera_block = UNBOUND;
+  block_buffer = 0;
+  viewport.reset();
+  clear_color.reset();
+}
+
+void
+loki::RenderQueue::push(loki::u64 key, const loki::DrawCommand& command)
+{
+  entries.push_back({ key, static_cast<u32>(commands.size()) });
+  commands.push_back(command);
+}
+
+void
+loki::RenderQueue::set_camera(const glm::mat4& _view, const glm::mat4& _projection)
+{
+  view = _view;
+  projection = _projection;
+}
+
+void
+loki::RenderQueue::set_viewport(const glm::ivec2& size)
+{
+  viewport = size;
+}
+
+void
+loki::RenderQueue::set_clear_color(const glm::vec4& color)
+{
+  clear_color = color;
+}
+
+void
+loki::RenderQueue::sort()
+{
+  if (entries.size() < 2) {
+    return;
+  }
+
+  // LSD radix sort, 8 bits per pass. All eight histograms come from one read of the keys,
+  // and a pass is skipped when every key has the same digit (unused key bits are common).
+  std::array<std::array<u32, 256>, 8> histograms{};
+  for (const auto& entry : entries) {
+    for (size_t pass = 0; pass < histograms.size(); ++pass) {
+      ++histograms[pass][(entry.key >> (pass * 8)) & 0xFF];
+    }
+  }
+
+  scratch.resize(entries.size());
+
+  for (size_t pass = 0; pass < histograms.size(); ++pass) {
+    auto& histogram = histograms[pass];
+    if (histogram[(entries.front().key >> (pass * 8)) & 0xFF] == entries.size()) {
+      continue;
+    }
+
+    u32 offset = 0;
+    for (auto& count : histogram) {
+      u32 bucket_size = count;
+      count = offset;
+      offset += bucket_size;
+    }
+
+    for (const auto& entry : entries) {
+      scratch[histogram[(entry.key >> (pass * 8)) & 0xFF]++] = entry;
+    }
+
+    entries.swap(scratch);
+  }
+}
+
+void
+loki::RenderQueue::upload(loki::StreamBuffer& stream)
+{
+  draw_blocks.assign(entries.size(), UNBOUND);
+  if (entries.empty()) {
+    return;
+  }
+
+  block_buffer = stream.get_buffer();
+
+  if (auto allocation = stream.allocate_uniforms(sizeof(CameraBlock))) {
+    CameraBlock block{ view, projection };
+    std::memcpy(allocation.data, &block, sizeof(block));
+    camera_block = allocation.offset;
+  }
+
+  u32 requested_program = UNBOUND;
+  bool uses_draw_block = false;
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const DrawCommand& command = commands[entries[i].index];
+
+    // Sorted by program, so this resolves once per run of draws
+    if (command.program.get_id() != requested_program) {
+      requested_program = command.program.get_id();
+      auto resolved = ShaderManager::resolve_program(command.program);
+      uses_draw_block = resolved && has_block(*resolved, UniformBlock::DRAW);
+    }
+
+    if (!uses_draw_block) {
+      continue;
+    }
+
+    if (auto allocation = stream.allocate_uniforms(sizeof(DrawBlock))) {
+      DrawBlock block{ command.model };
+      std::memcpy(allocation.data, &block, sizeof(block));
+      draw_blocks[i] = allocation.offset;
+    }
+  }
+}
+
+void
+loki::RenderQueue::submit(loki::GpuTimerPool& gpu_timers)
+{
+  using namespace literals;
+
+  stats = RenderStats{};
+  stats.commands = static_cast<u32>(entries.size());
+
+  if (viewport) {
+    glViewport(0, 0, viewport->x, viewport->y);
+  }
+
+  if (clear_color) {
+    GpuTimerScope gpu_zone{ gpu_timers, "Clear" };
+    glClearColor(clear_color->r, clear_color->g, clear_color->b, clear_color->a);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  }
+
+  u32 requested_program = UNBOUND;
+  u32 bound_program = UNBOUND;
+  u32 bound_vertex_array = UNBOUND;
+  u32 bound_texture = UNBOUND;
+  std::optional<UniformManager> uniforms;
+  bool uses_draw_block = false;
+
+  if (!entries.empty()) {
+    glActiveTexture(GL_TEXTURE0);
+  }
+
+  // The binding point is shared by all programs, so the camera is bound once per frame
+  if (camera_block != UNBOUND) {
+    glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBlock::CAMERA), block_buffer, camera_block, sizeof(CameraBlock));
+    ++stats.uniform_block_binds;
+  }
+
+  // The entries are sorted by pass, each one gets a GPU zone of its own
+  std::optional<RenderPass> current_pass;
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const DrawCommand& command = commands[entries[i].index];
+
+    RenderPass pass = get_pass(entries[i].key);
+    if (pass != current_pass) {
+      if (current_pass) {
+        gpu_timers.end_zone();
+      }
+
+      gpu_timers.begin_zone(get_pass_name(pass));
+      current_pass = pass;
+    }
+
+    if (command.program.get_id() != requested_program) {
+      requested_program = command.program.get_id();
+
+      // A program that is still compiling may resolve to the default one, which could be bound already
+      auto resolved = ShaderManager::resolve_program(command.program);
+      if (!resolved) {
+        // The program stays in use, but the next one that resolves to it has to set its uniforms again
+        bound_program = UNBOUND;
+        uniforms.reset();
+      } else if (resolved->get_id() != bound_program) {
+        bound_program = resolved->get_id();
+        glUseProgram(bound_program);
+        ++stats.program_binds;
+
+        uniforms.emplace(*resolved);
+        uses_draw_block = has_block(*resolved, UniformBlock::DRAW);
+        if (camera_block == UNBOUND || !has_block(*resolved, UniformBlock::CAMERA)) {
+          uniforms->set_uniform("view"_sid, view);
+          uniforms->set_uniform("projection"_sid, projection);
+        }
+      }
+    }
+
+    if (!uniforms) {
+      ++stats.skipped;
+      continue;
+    }
+
+    // A program with a Draw block has no "model" uniform to fall back on, when upload() ran out of stream
+    // buffer space for it the draw would get the previous draw's transform
+    bool has_draw_block = draw_blocks.size() == entries.size() && draw_blocks[i] != UNBOUND;
+    if (uses_draw_block && !has_draw_block) {
+      ++stats.skipped;
+      continue;
+    }
+
+    if (command.vertex_array != bound_vertex_array) {
+      bound_vertex_array = command.vertex_array;
+      glBindVertexArray(bound_vertex_array);
+      ++stats.vertex_array_binds;
+    }
+
+    if (command.texture != bound_texture) {
+      bound_texture = command.texture;
+      glBindTexture(GL_TEXTURE_2D, bound_texture);
+      ++stats.texture_binds;
+    }
+
+    if (has_draw_block) {
+      glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBlock::DRAW), block_buffer, draw_blocks[i], sizeof(DrawBlock));
+      ++stats.uniform_block_binds;
+    } else {
+      uniforms->set_uniform("model"_sid, command.model);
+    }
+
+    if (command.index_type) {
+      auto offset = static_cast<uintptr_t>(command.first) * get_index_size(command.index_type);
+      glDrawElements(command.mode, command.count, command.index_type, reinterpret_cast<const void*>(offset));
+    } else {
+      glDrawArrays(command.mode, command.first, command.count);
+    }
+
+    ++stats.draw_calls;
+  }
+
+  if (current_pass) {
+    gpu_timers.end_zone();
+  }
+
+  if (bound_program != UNBOUND) {
+    glUseProgram(0);
+  }
+
+  if (bound_vertex_array != UNBOUND) {
+    glBindVertexArray(0);
+  }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+#include "engine/memory/memory_domain.h"
+#include "engine/render/gpu_timer.h"
+#include "engine/render/shader.h"
+#include "engine/render/stream_buffer.h"
+#include "engine/utils/types.h"
+#include "glm/mat4x4.hpp"
+#include "glm/vec2.hpp"
+#include "glm/vec4.hpp"
+
+namespace loki {
+
+  // Passes are submitted in this order
+  enum class RenderPass : u8
+  {
+    OPAQUE = 0,
+    SKYBOX = 1,
+    TRANSPARENT = 2,
+    OVERLAY = 3,
+  };
+
+  struct DrawCommand
+  {
+    ProgramHandle program{};
+    u32 vertex_array{ 0 };
+    u32 texture{ 0 };
+    u32 mode{ GL_TRIANGLES };
+    // 0 means glDrawArrays, otherwise GL_UNSIGNED_BYTE/SHORT/INT for glDrawElements
+    u32 index_type{ 0 };
+    i32 first{ 0 };
+    i32 count{ 0 };
+    glm::mat4 model{ 1.f };
+  };
+
+  struct RenderStats
+  {
+    u32 commands{ 0 };
+    u32 draw_calls{ 0 };
+    u32 program_binds{ 0 };
+    u32 vertex_array_binds{ 0 };
+    u32 texture_binds{ 0 };
+    u32 uniform_block_binds{ 0 };
+    u32 skipped{ 0 };
+  };
+
+  // Draws are recorded as a 64-bit sort key plus a payload, radix-sorted once per frame and submitted
+  // with every program, VAO and texture bind that wouldn't change anything filtered out.
+  //
+  // Programs that declare the "Camera" and "Draw" uniform blocks (std140) get view/projection and the
+  // model matrix from the stream buffer, the others still go through glUniform calls:
+  //   layout(std140) uniform Camera { mat4 view; mat4 projection; };
+  //   layout(std140) uniform Draw { mat4 model; };
+  class RenderQueue
+  {
+  public:
+    // Opaque keys are pass | program | material | depth (front to back), transparent ones put the
+    // inverted depth right after the pass, blending needs back to front more than it needs fewer binds.
+    static auto make_key(RenderPass pass, ProgramHandle program, u16 material, float depth) -> u64;
+
+  public:
+    void reset();
+    void push(u64 key, const DrawCommand& command);
+    void set_camera(const glm::mat4& view, const glm::mat4& projection);
+    // Applied by submit() before the first draw, recording a frame never touches GL itself
+    void set_viewport(const glm::ivec2& size);
+    void set_clear_color(const glm::vec4& color);
+
+    void sort();
+    // Writes the uniform blocks in submission order, the stream buffer has to be flushed before submit()
+    void upload(StreamBuffer& stream);
+    // Every pass is timed as a GPU zone of its own
+    void submit(GpuTimerPool& gpu_timers);
+
+    auto get_stats() const -> const RenderStats&
+    {
+      return stats;
+    }
+
+  private:
+    struct SortEntry
+    {
+      u64 key;
+      u32 index;
+    };
+
+  private:
+    std::pmr::vector<SortEntry> entries{ get_memory_resource(MemoryDomain::RENDER) };
+    std::pmr::vector<SortEntry> scratch{ get_memory_resource(MemoryDomain::RENDER) };
+    std::pmr::vector<DrawCommand> commands{ get_memory_resource(MemoryDomain::RENDER) };
+    // Offsets of the per-draw blocks, in sorted order
+    std::pmr::vector<u32> draw_blocks{ get_memory_resource(MemoryDomain::RENDER) };
+    u32 camera_block{ 0xFFFF'FFFF };
+    u32 block_buffer{ 0 };
+    glm::mat4 view{ 1.f };
+    glm::mat4 projection{ 1.f };
+    std::optional<glm::ivec2> viewport;
+    std::optional<glm::vec4> clear_color;
+    RenderStats stats;
+  };
+
+} // namespace loki
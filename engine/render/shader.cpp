@@ -2,40 +2,216 @@
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
 #include <glm/gtc/type_ptr.hpp>
+#include <unordered_map>
 #include <vector>
 
-auto
-loki::ShaderManager::create_shader(const std::string& source, ShaderType type) -> loki::ShaderHandle
-{
-  uint32_t shader_id;
-  switch (type) {
-    case ShaderType::VERT:
-      shader_id = glCreateShader(GL_VERTEX_SHADER);
-      break;
-    case ShaderType::FRAG:
-      shader_id = glCreateShader(GL_FRAGMENT_SHADER);
-      break;
+#include "libassert/assert.hpp"
+
+namespace {
+
+  struct ProgramInfo
+  {
+    loki::UniformTable uniforms;
+    bool ready{ false };
+  };
+
+  // Compile and link are already issued to the driver, nobody has asked for their status yet
+  struct PendingProgram
+  {
+    GLuint program_id{ 0 };
+    GLuint vert_id{ 0 };
+    GLuint frag_id{ 0 };
+    bool use_cache{ false };
+    loki::ProgramBinaryCache::Key key{};
+    std::chrono::steady_clock::time_point start;
+  };
+
+  constexpr std::pair<loki::UniformBlock, const char*> UNIFORM_BLOCK_NAMES[] = {
+    { loki::UniformBlock::CAMERA, "Camera" },
+    { loki::UniformBlock::DRAW, "Draw" },
+  };
+
+  // Without parallel compile support every status query blocks, so only this many are finished per poll
+  constexpr size_t BLOCKING_FINISH_BUDGET = 1;
+
+  // Programs are only touched on the thread that owns the GL context
+  std::unordered_map<uint32_t, ProgramInfo> programs;
+  std::vector<PendingProgram> pending_programs;
+  loki::ProgramStats program_stats;
+  uint32_t default_program_id{ 0 };
+  bool parallel_compile{ false };
+
+  auto compile_shader(const std::string& source, loki::ShaderType type) -> GLuint
+  {
+    GLuint shader_id = 0;
+    switch (type) {
+      case loki::ShaderType::VERT:
+        shader_id = glCreateShader(GL_VERTEX_SHADER);
+        break;
+      case loki::ShaderType::FRAG:
+        shader_id = glCreateShader(GL_FRAGMENT_SHADER);
+        break;
+    }
+
+    const char* source_data = source.data();
+    glShaderSource(shader_id, 1, (const GLchar**)&source_data, nullptr);
+    glCompileShader(shader_id);
+
+    return shader_id;
+  }
+
+  auto check_compile_status(GLuint shader_id, loki::ShaderType type) -> bool
+  {
+    GLint shader_compiled;
+    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &shader_compiled);
+
+    if (!shader_compiled) {
+      int log_msg_len;
+      glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &log_msg_len);
+      std::vector<char> shader_log(log_msg_len + 1);
+      glGetShaderInfoLog(shader_id, log_msg_len, &log_msg_len, shader_log.data());
+      shader_log.at(log_msg_len) = 0;
+      spdlog::error("Shader compilation failed, the compile log: {}", shader_log.data());
+    } else {
+      spdlog::info("Shader {} compiled successfully", type);
+    }
+
+    return shader_compiled;
+  }
+
+  auto check_link_status(GLuint program_id) -> bool
+  {
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &linked);
+
+    if (!linked) {
+      int log_msg_len;
+      glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &log_msg_len);
+      std::vector<char> program_log(log_msg_len + 1);
+      glGetProgramInfoLog(program_id, log_msg_len, &log_msg_len, program_log.data());
+      program_log.at(log_msg_len) = 0;
+      spdlog::error("Program linking failed, the link log: {}", program_log.data());
+    }
+
+    return linked;
+  }
+
+  void finish_program(GLuint program_id, bool linked, bool from_cache, std::chrono::steady_clock::time_point start)
+  {
+    auto& info = programs[program_id];
+    info.ready = linked;
+    if (linked) {
+      info.uniforms.build(program_id);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    program_stats.seconds += seconds;
+    if (from_cache) {
+      ++program_stats.loaded_from_cache;
+    } else {
+      ++program_stats.linked_from_source;
+    }
+
+    spdlog::info("Program {} {} in {:.2f} ms", program_id, from_cache ? "loaded from cache" : "linked from source", seconds * 1'000.0);
   }
 
-  const char* source_data = source.data();
-  glShaderSource(shader_id, 1, (const GLchar**)&source_data, nullptr);
-  glCompileShader(shader_id);
+  void finish_pending(const PendingProgram& pending)
+  {
+    bool linked = check_link_status(pending.program_id);
+    if (!linked) {
+      // The compile logs say more than the link log about what went wrong
+      check_compile_status(pending.vert_id, loki::ShaderType::VERT);
+      check_compile_status(pending.frag_id, loki::ShaderType::FRAG);
+    }
+
+    glDetachShader(pending.program_id, pending.vert_id);
+    glDetachShader(pending.program_id, pending.frag_id);
+    glDeleteShader(pending.vert_id);
+    glDeleteShader(pending.frag_id);
 
-  GLint shader_compiled;
-  glGetShaderiv(shader_id, GL_COMPILE_STATUS, &shader_compiled);
+    if (linked && pending.use_cache) {
+      loki::ProgramBinaryCache::store(pending.key, pending.program_id);
+    }
+
+    finish_program(pending.program_id, linked, false, pending.start);
+  }
 
-  if (!shader_compiled) {
-    int log_msg_len;
-    glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &log_msg_len);
-    std::vector<char> shader_log(log_msg_len + 1);
-    glGetShaderInfoLog(shader_id, log_msg_len, &log_msg_len, shader_log.data());
-    shader_log.at(log_msg_len) = 0;
-    spdlog::error("Shader compilation failed, the compile log: {}", shader_log.data());
-  } else {
-    spdlog::info("Shader {} compiled successfully", type);
+  // Every sampler type core GL has, plain, int and unsigned int
+  auto is_sampler_type(GLenum type) -> bool
+  {
+    switch (type) {
+      case GL_SAMPLER_1D:
+      case GL_SAMPLER_2D:
+      case GL_SAMPLER_3D:
+      case GL_SAMPLER_CUBE:
+      case GL_SAMPLER_1D_SHADOW:
+      case GL_SAMPLER_2D_SHADOW:
+      case GL_SAMPLER_1D_ARRAY:
+      case GL_SAMPLER_2D_ARRAY:
+      case GL_SAMPLER_1D_ARRAY_SHADOW:
+      case GL_SAMPLER_2D_ARRAY_SHADOW:
+      case GL_SAMPLER_2D_MULTISAMPLE:
+      case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+      case GL_SAMPLER_CUBE_SHADOW:
+      case GL_SAMPLER_BUFFER:
+      case GL_SAMPLER_2D_RECT:
+      case GL_SAMPLER_2D_RECT_SHADOW:
+      case GL_SAMPLER_CUBE_MAP_ARRAY:
+      case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+      case GL_INT_SAMPLER_1D:
+      case GL_INT_SAMPLER_2D:
+      case GL_INT_SAMPLER_3D:
+      case GL_INT_SAMPLER_CUBE:
+      case GL_INT_SAMPLER_1D_ARRAY:
+      case GL_INT_SAMPLER_2D_ARRAY:
+      case GL_INT_SAMPLER_2D_MULTISAMPLE:
+      case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+      case GL_INT_SAMPLER_BUFFER:
+      case GL_INT_SAMPLER_2D_RECT:
+      case GL_INT_SAMPLER_CUBE_MAP_ARRAY:
+      case GL_UNSIGNED_INT_SAMPLER_1D:
+      case GL_UNSIGNED_INT_SAMPLER_2D:
+      case GL_UNSIGNED_INT_SAMPLER_3D:
+      case GL_UNSIGNED_INT_SAMPLER_CUBE:
+      case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+      case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+      case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+      case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+      case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+      case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+      case GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY:
+        return true;
+      default:
+        return false;
+    }
   }
 
+} // namespace
+
+void
+loki::ShaderManager::init()
+{
+  // Let the driver compile on as many threads as it wants, GL_COMPLETION_STATUS then tells us when it's done
+  if (GLEW_KHR_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsKHR(0xFFFF'FFFF);
+    parallel_compile = true;
+  } else if (GLEW_ARB_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsARB(0xFFFF'FFFF);
+    parallel_compile = true;
+  }
+
+  spdlog::info("Parallel shader compilation is {}", parallel_compile ? "enabled" : "not supported");
+}
+
+auto
+loki::ShaderManager::create_shader(const std::string& source, ShaderType type) -> loki::ShaderHandle
+{
+  uint32_t shader_id = compile_shader(source, type);
+  check_compile_status(shader_id, type);
+
   loki::ShaderHandle handle{};
   handle.id = shader_id;
 
@@ -50,28 +226,287 @@ loki::ShaderManager::create_program(loki::ShaderHandle vert, loki::ShaderHandle
   glAttachShader(shader_program, frag.id);
   glLinkProgram(shader_program);
 
+  auto& info = programs[shader_program];
+  info.ready = check_link_status(shader_program);
+  info.uniforms.build(shader_program);
+
   loki::ProgramHandle handle{};
   handle.id = shader_program;
 
   return handle;
 }
 
+auto
+loki::ShaderManager::create_program(const loki::ProgramSource& source) -> loki::ProgramHandle
+{
+  ProgramHandle handle = submit_program(source);
+
+  // The blocking path, finish it right away instead of waiting for poll_programs()
+  auto it = std::find_if(pending_programs.begin(), pending_programs.end(), [&handle](const PendingProgram& pending) {
+    return pending.program_id == handle.id;
+  });
+
+  if (it != pending_programs.end()) {
+    PendingProgram pending = *it;
+    pending_programs.erase(it);
+    finish_pending(pending);
+  }
+
+  return handle;
+}
+
+auto
+loki::ShaderManager::submit_program(const loki::ProgramSource& source) -> loki::ProgramHandle
+{
+  PendingProgram pending;
+  pending.start = std::chrono::steady_clock::now();
+  pending.program_id = glCreateProgram();
+  pending.use_cache = ProgramBinaryCache::is_enabled();
+
+  loki::ProgramHandle handle{};
+
+  if (pending.use_cache) {
+    pending.key = ProgramBinaryCache::make_key(source);
+    if (ProgramBinaryCache::load(pending.key, pending.program_id)) {
+      finish_program(pending.program_id, true, true, pending.start);
+      handle.id = pending.program_id;
+      return handle;
+    }
+
+    // Start over with a clean object, a rejected binary may leave the old one in a weird state
+    glDeleteProgram(pending.program_id);
+    pending.program_id = glCreateProgram();
+    glProgramParameteri(pending.program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+
+  // Only issue the work here, any status query would wait for the compiler
+  pending.vert_id = compile_shader(source.vert, ShaderType::VERT);
+  pending.frag_id = compile_shader(source.frag, ShaderType::FRAG);
+  glAttachShader(pending.program_id, pending.vert_id);
+  glAttachShader(pending.program_id, pending.frag_id);
+  glLinkProgram(pending.program_id);
+
+  programs[pending.program_id].ready = false;
+  pending_programs.push_back(pending);
+
+  handle.id = pending.program_id;
+  return handle;
+}
+
+void
+loki::ShaderManager::poll_programs()
+{
+  size_t finished = 0;
+
+  for (auto it = pending_programs.begin(); it != pending_programs.end();) {
+    if (parallel_compile) {
+      GLint completed = GL_FALSE;
+      glGetProgramiv(it->program_id, GL_COMPLETION_STATUS_KHR, &completed);
+      if (!completed) {
+        ++it;
+        continue;
+      }
+    } else if (finished >= BLOCKING_FINISH_BUDGET) {
+      break;
+    }
+
+    PendingProgram pending = *it;
+    it = pending_programs.erase(it);
+    finish_pending(pending);
+    ++finished;
+  }
+}
+
+auto
+loki::ShaderManager::is_ready(loki::ProgramHandle handle) -> bool
+{
+  auto it = programs.find(handle.id);
+  return it != programs.end() && it->second.ready;
+}
+
+auto
+loki::ShaderManager::get_pending_count() -> size_t
+{
+  return pending_programs.size();
+}
+
+auto
+loki::ShaderManager::resolve_program(loki::ProgramHandle handle) -> std::optional<ProgramHandle>
+{
+  // Programs that are still compiling are replaced by the default one, without it the draw is skipped
+  if (is_ready(handle)) {
+    return handle;
+  }
+
+  if (!default_program_id) {
+    return std::nullopt;
+  }
+
+  handle.id = default_program_id;
+  return handle;
+}
+
+void
+loki::ShaderManager::set_default_program(loki::ProgramHandle handle)
+{
+  default_program_id = handle.id;
+}
+
+auto
+loki::ShaderManager::get_program_stats() -> loki::ProgramStats
+{
+  return program_stats;
+}
+
+auto
+loki::ShaderManager::get_uniform_table(loki::ProgramHandle handle) -> const loki::UniformTable*
+{
+  auto it = programs.find(handle.id);
+  return it != programs.end() ? &it->second.uniforms : nullptr;
+}
+
+void
+loki::UniformTable::build(uint32_t program_id)
+{
+  uniforms.clear();
+
+  GLint count = 0;
+  glGetProgramiv(program_id, GL_ACTIVE_UNIFORMS, &count);
+  GLint max_length = 0;
+  glGetProgramiv(program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+  std::vector<char> name(std::max(max_length, 1));
+  for (GLint i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(program_id, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+
+    // Members of uniform blocks have no location, they're fed through buffers
+    GLint location = glGetUniformLocation(program_id, name.data());
+    if (location < 0) {
+      continue;
+    }
+
+    std::string_view view{ name.data(), (size_t)length };
+    uniforms.push_back({ StringID{ view }, location, type, size });
+
+    // Arrays are reported as "name[0]", make them reachable by the plain name too
+    if (view.ends_with("[0]")) {
+      uniforms.push_back({ StringID{ view.substr(0, view.size() - 3) }, location, type, size });
+    }
+  }
+
+  std::sort(uniforms.begin(), uniforms.end(), [](const UniformInfo& a, const UniformInfo& b) {
+    return a.name.get_id() < b.name.get_id();
+  });
+
+  // Block bindings aren't kept in program binaries, so this has to run for cached programs too
+  blocks = 0;
+  for (auto [block, block_name] : UNIFORM_BLOCK_NAMES) {
+    GLuint index = glGetUniformBlockIndex(program_id, block_name);
+    if (index != GL_INVALID_INDEX) {
+      glUniformBlockBinding(program_id, index, static_cast<GLuint>(block));
+      blocks |= 1u << static_cast<uint32_t>(block);
+    }
+  }
+
+  spdlog::info("Program {} has {} active uniforms", program_id, uniforms.size());
+}
+
+auto
+loki::UniformTable::find(loki::StringID name) const -> const loki::UniformInfo*
+{
+  auto it = std::lower_bound(uniforms.begin(), uniforms.end(), name.get_id(), [](const UniformInfo& info, u64 id) {
+    return info.name.get_id() < id;
+  });
+
+  return it != uniforms.end() && it->name == name ? &*it : nullptr;
+}
+
 auto
 loki::ShaderManager::use_program(loki::ProgramHandle handle, const std::function<void(const UniformManager& manager)>& callback) -> void
 {
-  glUseProgram(handle.id);
-  callback(UniformManager{ handle });
+  auto resolved = resolve_program(handle);
+  if (!resolved) {
+    return;
+  }
+
+  glUseProgram(resolved->id);
+  callback(UniformManager{ *resolved });
   glUseProgram(0);
 }
 
+loki::UniformManager::UniformManager(loki::ProgramHandle handle)
+  : handle{ handle }
+  , table{ ShaderManager::get_uniform_table(handle) }
+{
+}
+
+auto
+loki::UniformManager::get_location(loki::StringID name, uint32_t type) const -> int32_t
+{
+  const UniformInfo* info = table ? table->find(name) : nullptr;
+  if (!info) {
+    return -1;
+  }
+
+  // Bools are set with glUniform1i like ints, samplers have an overload of their own
+  DEBUG_ASSERT(info->type == type || (type == GL_INT && info->type == GL_BOOL), "Uniform type mismatch", name.c_str(), info->type, type);
+  return info->location;
+}
+
+auto
+loki::UniformManager::get_sampler_location(loki::StringID name) const -> int32_t
+{
+  const UniformInfo* info = table ? table->find(name) : nullptr;
+  if (!info) {
+    return -1;
+  }
+
+  DEBUG_ASSERT(is_sampler_type(info->type), "Uniform isn't a sampler", name.c_str(), info->type);
+  return info->location;
+}
+
+auto
+loki::UniformManager::set_uniform(loki::StringID name, int32_t value) const -> void
+{
+  glUniform1i(get_location(name, GL_INT), value);
+}
+
 auto
 loki::UniformManager::set_uniform(loki::StringID name, float value) const -> void
 {
-  glUniform1f(glGetUniformLocation(handle.id, name.to_string().c_str()), value);
+  glUniform1f(get_location(name, GL_FLOAT), value);
+}
+
+auto
+loki::UniformManager::set_uniform(loki::StringID name, const glm::vec2& vec) const -> void
+{
+  glUniform2fv(get_location(name, GL_FLOAT_VEC2), 1, glm::value_ptr(vec));
+}
+
+auto
+loki::UniformManager::set_uniform(loki::StringID name, const glm::vec3& vec) const -> void
+{
+  glUniform3fv(get_location(name, GL_FLOAT_VEC3), 1, glm::value_ptr(vec));
+}
+
+auto
+loki::UniformManager::set_uniform(loki::StringID name, const glm::vec4& vec) const -> void
+{
+  glUniform4fv(get_location(name, GL_FLOAT_VEC4), 1, glm::value_ptr(vec));
 }
 
 auto
 loki::UniformManager::set_uniform(loki::StringID name, const glm::mat4& mat) const -> void
 {
-  glUniformMatrix4fv(glGetUniformLocation(handle.id, name.to_string().c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+  glUniformMatrix4fv(get_location(name, GL_FLOAT_MAT4), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+auto
+loki::UniformManager::set_uniform(loki::StringID name, loki::SamplerUnit sampler) const -> void
+{
+  // Samplers are plain ints on the GL side, the separate overload keeps them from being mixed up with values
+  glUniform1i(get_sampler_location(name), sampler.unit);
 }
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
 #include <format>
 #include <spdlog/spdlog.h>
 #include <string>
+#include <vector>
 
+#include "engine/render/program_cache.h"
 #include "engine/string_manager.h"
 #include "glm/fwd.hpp"
 
@@ -31,32 +34,116 @@ namespace loki {
     friend struct ShaderManager;
     friend class UniformManager;
 
+  public:
+    auto get_id() const -> uint32_t
+    {
+      return id;
+    }
+
+    bool operator==(const ProgramHandle& other) const
+    {
+      return id == other.id;
+    }
+
   private:
     uint32_t id;
   };
 
-  class UniformManager
+  // Texture unit a sampler uniform reads from
+  struct SamplerUnit
+  {
+    int32_t unit{ 0 };
+  };
+
+  struct UniformInfo
+  {
+    StringID name;
+    int32_t location{ -1 };
+    uint32_t type{ 0 };
+    int32_t size{ 0 };
+  };
+
+  // Binding points of the engine's uniform blocks, a block declared as "Camera" or "Draw" is bound at link time
+  enum class UniformBlock : uint32_t
+  {
+    CAMERA = 0,
+    DRAW = 1,
+  };
+
+  // Active uniforms of a linked program sorted by name ID, built once by introspection at link time
+  class UniformTable
   {
   public:
-    explicit UniformManager(ProgramHandle handle)
-      : handle{ handle }
+    void build(uint32_t program_id);
+    auto find(StringID name) const -> const UniformInfo*;
+
+    auto has_block(UniformBlock block) const -> bool
     {
+      return blocks & (1u << static_cast<uint32_t>(block));
     }
 
+    auto get_uniforms() const -> const std::vector<UniformInfo>&
+    {
+      return uniforms;
+    }
+
+  private:
+    std::vector<UniformInfo> uniforms;
+    uint32_t blocks{ 0 };
+  };
+
+  class UniformManager
+  {
   public:
+    explicit UniformManager(ProgramHandle handle);
+
+  public:
+    auto set_uniform(StringID name, int32_t value) const -> void;
     auto set_uniform(StringID name, float value) const -> void;
+    auto set_uniform(StringID name, const glm::vec2& vec) const -> void;
+    auto set_uniform(StringID name, const glm::vec3& vec) const -> void;
+    auto set_uniform(StringID name, const glm::vec4& vec) const -> void;
     auto set_uniform(StringID name, const glm::mat4& mat) const -> void;
+    auto set_uniform(StringID name, SamplerUnit sampler) const -> void;
+
+  private:
+    // -1 when the program has no such active uniform, GL silently ignores uploads to it
+    auto get_location(StringID name, uint32_t type) const -> int32_t;
+    auto get_sampler_location(StringID name) const -> int32_t;
 
   private:
     ProgramHandle handle;
+    const UniformTable* table;
+  };
+
+  struct ProgramStats
+  {
+    uint32_t loaded_from_cache{ 0 };
+    uint32_t linked_from_source{ 0 };
+    double seconds{ 0.0 };
   };
 
   struct ShaderManager
   {
     // general stuff
+    static void init();
     static auto create_shader(const std::string& source, ShaderType type) -> ShaderHandle;
     static auto create_program(ShaderHandle vert, ShaderHandle frag) -> ProgramHandle;
+    // Goes through the program binary cache and compiles from source only when that misses
+    static auto create_program(const ProgramSource& source) -> ProgramHandle;
+    static auto get_program_stats() -> ProgramStats;
+
+    // Asynchronous path: submit every variant up front, the handle becomes ready once poll_programs()
+    // sees the driver is done with it. Until then use_program() binds the default program instead.
+    static auto submit_program(const ProgramSource& source) -> ProgramHandle;
+    static void poll_programs();
+    static auto is_ready(ProgramHandle handle) -> bool;
+    // The program that actually gets bound for this handle: itself, the default one, or nothing at all
+    static auto resolve_program(ProgramHandle handle) -> std::optional<ProgramHandle>;
+    static auto get_pending_count() -> size_t;
+    static void set_default_program(ProgramHandle handle);
     static auto use_program(ProgramHandle handle, const std::function<void(const UniformManager& manager)>& callback) -> void;
+    static auto get_uniform_table(ProgramHandle handle) -> const UniformTable*;
   };
 } // namespace loki
 
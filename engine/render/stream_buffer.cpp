@@ -0,0 +1,191 @@
+#include "stream_buffer.h"
+
+#include <algorithm>
+
+#include "libassert/assert.hpp"
+#include "spdlog/spdlog.h"
+
+namespace {
+
+  // Nanoseconds per glClientWaitSync call, the wait is retried until the fence signals
+  constexpr GLuint64 FENCE_WAIT_TIMEOUT = 1'000'000;
+
+} // namespace
+
+loki::StreamBuffer::~StreamBuffer()
+{
+  term();
+}
+
+auto
+loki::StreamBuffer::init(loki::u32 _frame_size) -> bool
+{
+  GLint alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  uniform_alignment = std::max<u32>(alignment, 1);
+
+  // Regions start aligned, so an allocation at the start of one is good for any target
+  frame_size = (_frame_size + uniform_alignment - 1) / uniform_alignment * uniform_alignment;
+  persistent = GLEW_ARB_buffer_storage;
+
+  GLsizeiptr total_size = static_cast<GLsizeiptr>(frame_size) * FRAME_COUNT;
+
+  // GL_COPY_WRITE_BUFFER doesn't touch the array buffer binding of whatever VAO is bound
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+  if (persistent) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_COPY_WRITE_BUFFER, total_size, nullptr, flags);
+    mapped = static_cast<u8*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total_size, flags));
+  } else {
+    glBufferData(GL_COPY_WRITE_BUFFER, total_size, nullptr, GL_STREAM_DRAW);
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  if (persistent && !mapped) {
+    spdlog::error("Failed to map the stream buffer persistently");
+    term();
+    return false;
+  }
+
+  spdlog::info("Stream buffer: {} x {} KiB, {} mapping", FRAME_COUNT, frame_size / 1'024, persistent ? "persistent" : "unsynchronized");
+  return true;
+}
+
+void
+loki::StreamBuffer::term()
+{
+  for (auto& fence : fences) {
+    if (fence) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+
+  if (buffer) {
+    // Deleting the buffer unmaps it too
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+  }
+
+  mapped = nullptr;
+}
+
+void
+loki::StreamBuffer::begin_frame()
+{
+  if (!buffer) {
+    return;
+  }
+
+  GLsync& fence = fences[frame_index];
+  if (fence) {
+    // Only flush the command queue if the fence isn't signalled yet, otherwise the wait could never end
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+      ++stats.fence_waits;
+      do {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_TIMEOUT);
+      } while (result == GL_TIMEOUT_EXPIRED);
+    }
+
+    if (result == GL_WAIT_FAILED) {
+      spdlog::error("Waiting for the stream buffer fence failed");
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  cursor = 0;
+  stats.allocations = 0;
+  stats.used_bytes = 0;
+
+  if (!persistent) {
+    // The fence already guarantees the GPU is done with this region, the driver doesn't have to check again
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    mapped = static_cast<u8*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(frame_index) * frame_size, frame_size, flags));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (!mapped) {
+      spdlog::error("Failed to map the stream buffer region {}", frame_index);
+    }
+  }
+}
+
+auto
+loki::StreamBuffer::allocate(loki::u32 size, loki::u32 alignment) -> loki::StreamAllocation
+{
+  if (!mapped || size == 0) {
+    return {};
+  }
+
+  DEBUG_ASSERT(alignment > 0);
+
+  u32 region_offset = frame_index * frame_size;
+  u32 offset = (region_offset + cursor + alignment - 1) / alignment * alignment;
+  u32 end = offset - region_offset + size;
+
+  if (end > frame_size) {
+    // Don't spam, one warning per frame is enough to know the buffer is too small
+    if (cursor != frame_size) {
+      spdlog::warn("Stream buffer overflow, {} bytes requested with {} of {} used", size, cursor, frame_size);
+    }
+
+    ++stats.overflows;
+    cursor = frame_size;
+    return {};
+  }
+
+  cursor = end;
+  ++stats.allocations;
+  stats.used_bytes = cursor;
+  stats.peak_bytes = std::max(stats.peak_bytes, cursor);
+
+  // Unsynchronized mappings cover only the current region
+  u8* base = persistent ? mapped + offset : mapped + (offset - region_offset);
+  return { base, buffer, offset, size };
+}
+
+auto
+loki::StreamBuffer::allocate_uniforms(loki::u32 size) -> loki::StreamAllocation
+{
+  return allocate(size, uniform_alignment);
+}
+
+void
+loki::StreamBuffer::flush()
+{
+  // Coherent mappings need nothing, the writes become visible by the time the next command is issued
+  if (persistent || !mapped) {
+    return;
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+  if (cursor) {
+    glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, 0, cursor);
+  }
+
+  if (!glUnmapBuffer(GL_COPY_WRITE_BUFFER)) {
+    spdlog::warn("Stream buffer contents were lost while mapped");
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  mapped = nullptr;
+}
+
+void
+loki::StreamBuffer::end_frame()
+{
+  if (!buffer) {
+    return;
+  }
+
+  flush();
+
+  fences[frame_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  frame_index = (frame_index + 1) % FRAME_COUNT;
+}
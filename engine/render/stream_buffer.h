@@ -0,0 +1,102 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <array>
+
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  struct StreamAllocation
+  {
+    void* data{ nullptr };
+    u32 buffer{ 0 };
+    // From the start of the GL buffer, ready for glBindBufferRange or to be divided by a vertex stride
+    u32 offset{ 0 };
+    u32 size{ 0 };
+
+    explicit operator bool() const
+    {
+      return data != nullptr;
+    }
+  };
+
+  struct StreamStats
+  {
+    // Current frame
+    u32 allocations{ 0 };
+    u32 used_bytes{ 0 };
+    // Since init
+    u32 peak_bytes{ 0 };
+    u32 overflows{ 0 };
+    u32 fence_waits{ 0 };
+  };
+
+  // One GL buffer split into a region per frame in flight. The CPU writes this frame's region while the
+  // GPU reads the older ones, a fence per region keeps it from overwriting data that is still in use.
+  //
+  // With ARB_buffer_storage the whole buffer stays mapped (persistent and coherent), otherwise the current
+  // region is mapped unsynchronized in begin_frame() and unmapped in flush(), so no allocation can be made
+  // between flush() and end_frame() on that path.
+  //
+  // Dynamic vertices: bind get_buffer() as the GL_ARRAY_BUFFER of a VAO once, allocate with the vertex
+  // stride as the alignment and draw from offset / stride.
+  class StreamBuffer
+  {
+  public:
+    static constexpr u32 FRAME_COUNT = 3;
+
+  public:
+    StreamBuffer() = default;
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+    ~StreamBuffer();
+
+  public:
+    auto init(u32 frame_size) -> bool;
+    void term();
+
+    // Waits for the GPU to be done with the region from FRAME_COUNT frames ago
+    void begin_frame();
+    // Alignment doesn't have to be a power of two, vertex strides usually aren't
+    auto allocate(u32 size, u32 alignment) -> StreamAllocation;
+    // Aligned for glBindBufferRange(GL_UNIFORM_BUFFER, ...)
+    auto allocate_uniforms(u32 size) -> StreamAllocation;
+    // Makes this frame's writes visible to GL, has to come before the draws that read them
+    void flush();
+    void end_frame();
+
+    auto get_buffer() const -> u32
+    {
+      return buffer;
+    }
+
+    auto is_persistent() const -> bool
+    {
+      return persistent;
+    }
+
+    auto get_frame_size() const -> u32
+    {
+      return frame_size;
+    }
+
+    auto get_stats() const -> const StreamStats&
+    {
+      return stats;
+    }
+
+  private:
+    u32 buffer{ 0 };
+    u8* mapped{ nullptr };
+    u32 frame_size{ 0 };
+    u32 frame_index{ 0 };
+    u32 cursor{ 0 };
+    u32 uniform_alignment{ 256 };
+    bool persistent{ false };
+    std::array<GLsync, FRAME_COUNT> fences{};
+    StreamStats stats;
+  };
+
+} // namespace loki
@@ -1,65 +1,299 @@
 #include "string_manager.h"
 
-std::shared_mutex loki::StringManager::mutex;
-std::string loki::StringManager::invalid_string;
-std::unordered_map<loki::StringID, std::string> loki::StringManager::id_to_string;
-std::unordered_map<std::string, loki::StringID> loki::StringManager::string_to_id;
-std::size_t loki::StringManager::string_counter = 0;
-
-loki::StringID::StringID()
-  : id{ 0 }
-{
-}
+#include "engine/memory/memory_domain.h"
+#include "libassert/assert.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+  constexpr std::size_t SHARD_BITS = 6;
+  constexpr std::size_t SHARD_COUNT = std::size_t{ 1 } << SHARD_BITS;
+  constexpr std::size_t ARENA_BLOCK_SIZE = 0x10000;
+  constexpr std::size_t INITIAL_TABLE_SIZE = 0x100;
+
+  // Header of an interned string, the characters (null-terminated) follow it in the arena
+  struct Entry
+  {
+    loki::u64 hash;
+    std::size_t length;
+
+    auto get_data() const -> const char*
+    {
+      return reinterpret_cast<const char*>(this + 1);
+    }
+
+    auto get_view() const -> std::string_view
+    {
+      return { get_data(), length };
+    }
+  };
+
+  class Arena
+  {
+  public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena()
+    {
+      for (const auto& block : blocks) {
+        resource->deallocate(block.data, block.size, alignof(Entry));
+      }
+    }
+
+  public:
+    auto allocate(std::size_t size) -> void*
+    {
+      size = (size + alignof(Entry) - 1) & ~(alignof(Entry) - 1);
+
+      // Oversized strings get a block of their own, the current block keeps its free space
+      if (size > ARENA_BLOCK_SIZE) {
+        used_bytes += size;
+        return allocate_block(size);
+      }
+
+      if (size > free_bytes) {
+        cursor = allocate_block(ARENA_BLOCK_SIZE);
+        free_bytes = ARENA_BLOCK_SIZE;
+        used_bytes += ARENA_BLOCK_SIZE;
+      }
+
+      void* memory = cursor;
+      cursor += size;
+      free_bytes -= size;
+      return memory;
+    }
+
+    auto get_used_bytes() const -> std::size_t
+    {
+      return used_bytes;
+    }
+
+  private:
+    struct Block
+    {
+      std::byte* data;
+      std::size_t size;
+    };
+
+    auto allocate_block(std::size_t size) -> std::byte*
+    {
+      auto* data = static_cast<std::byte*>(resource->allocate(size, alignof(Entry)));
+      blocks.push_back({ data, size });
+      return data;
+    }
+
+  private:
+    std::pmr::memory_resource* resource{ loki::get_memory_resource(loki::MemoryDomain::STRINGS) };
+    std::vector<Block> blocks;
+    std::byte* cursor{ nullptr };
+    std::size_t free_bytes{ 0 };
+    std::size_t used_bytes{ 0 };
+  };
+
+  // Open addressing with linear probing. Slots only ever go from empty to an entry,
+  // so readers can probe without a lock while a writer is inserting.
+  struct Table
+  {
+    explicit Table(std::size_t size)
+      : mask{ size - 1 }
+      , slots{ std::make_unique<std::atomic<const Entry*>[]>(size) }
+    {
+    }
+
+    std::size_t mask;
+    std::unique_ptr<std::atomic<const Entry*>[]> slots;
+  };
+
+  class Shard
+  {
+  public:
+    Shard()
+      : table{ tables.emplace_back(std::make_unique<Table>(INITIAL_TABLE_SIZE)).get() }
+    {
+    }
+
+  public:
+    // The hash is the ID, so a lookup by ID and a lookup by string both come down to this probe
+    auto find(loki::u64 hash) const -> const Entry*
+    {
+      const Table* current = table.load(std::memory_order_acquire);
+      for (std::size_t i = hash & current->mask;; i = (i + 1) & current->mask) {
+        const Entry* entry = current->slots[i].load(std::memory_order_acquire);
+        if (!entry || entry->hash == hash) {
+          return entry;
+        }
+      }
+    }
+
+    void intern(loki::u64 hash, std::string_view string)
+    {
+      if (const Entry* entry = find(hash)) {
+        check_collision(*entry, string);
+        return;
+      }
+
+      std::lock_guard lock(mutex);
+
+      // Somebody may have inserted the same string while we were waiting for the lock
+      if (const Entry* entry = find(hash)) {
+        check_collision(*entry, string);
+        return;
+      }
+
+      auto* memory = static_cast<std::byte*>(arena.allocate(sizeof(Entry) + string.size() + 1));
+      auto* entry = new (memory) Entry{ hash, string.size() };
+      std::memcpy(memory + sizeof(Entry), string.data(), string.size());
+      memory[sizeof(Entry) + string.size()] = std::byte{ 0 };
+
+      // Keep the load factor under 1/2, so probe sequences stay short
+      Table* current = table.load(std::memory_order_relaxed);
+      if (++count * 2 > current->mask + 1) {
+        current = grow(*current);
+      }
 
-loki::StringID::StringID(const std::string& string)
+      insert(*current, entry, std::memory_order_release);
+    }
+
+    auto get_count() -> std::size_t
+    {
+      std::lock_guard lock(mutex);
+      return count;
+    }
+
+    auto get_memory_usage() -> std::size_t
+    {
+      std::lock_guard lock(mutex);
+
+      std::size_t bytes = arena.get_used_bytes();
+      for (const auto& t : tables) {
+        bytes += (t->mask + 1) * sizeof(std::atomic<const Entry*>);
+      }
+
+      return bytes;
+    }
+
+  private:
+    static void check_collision(const Entry& entry, std::string_view string)
+    {
+      // IDs are persisted, so two strings sharing a hash can't be resolved silently, one of them has to be renamed
+      if (entry.get_view() != string) {
+        spdlog::critical("StringID collision: \"{}\" and \"{}\" both hash to {:#018x}", entry.get_view(), string, entry.hash);
+        ASSERT(entry.get_view() == string, "StringID hash collision");
+      }
+    }
+
+    static void insert(Table& target, const Entry* entry, std::memory_order order)
+    {
+      std::size_t i = entry->hash & target.mask;
+      while (target.slots[i].load(std::memory_order_relaxed)) {
+        i = (i + 1) & target.mask;
+      }
+
+      target.slots[i].store(entry, order);
+    }
+
+    auto grow(const Table& current) -> Table*
+    {
+      Table* bigger = tables.emplace_back(std::make_unique<Table>((current.mask + 1) * 2)).get();
+      for (std::size_t i = 0; i <= current.mask; ++i) {
+        if (const Entry* entry = current.slots[i].load(std::memory_order_relaxed)) {
+          insert(*bigger, entry, std::memory_order_relaxed);
+        }
+      }
+
+      // Old tables stay alive, lock-free readers may still be probing them
+      table.store(bigger, std::memory_order_release);
+      return bigger;
+    }
+
+  private:
+    std::mutex mutex;
+    std::size_t count{ 0 };
+    Arena arena;
+    std::vector<std::unique_ptr<Table>> tables;
+    std::atomic<Table*> table;
+  };
+
+  auto get_shards() -> std::array<Shard, SHARD_COUNT>&
+  {
+    static std::array<Shard, SHARD_COUNT> shards;
+    return shards;
+  }
+
+  auto get_shard(loki::u64 hash) -> Shard&
+  {
+    // The table probes with the low bits, so pick the shard from the high ones
+    return get_shards()[hash >> (64 - SHARD_BITS)];
+  }
+
+} // namespace
+
+loki::StringID::StringID(std::string_view string)
   : id{ StringManager::get_id_by_string(string).id }
 {
 }
 
-bool
-loki::StringID::operator==(const loki::StringID& other) const
+auto
+loki::StringID::to_string_view() const -> std::string_view
 {
-  return id == other.id;
+  return StringManager::get_string_by_id(*this);
 }
 
 auto
-loki::StringID::to_string() const -> const std::string&
+loki::StringID::c_str() const -> const char*
 {
-  return StringManager::get_string_by_id(*this);
+  // Arena strings are null-terminated and so is the invalid one
+  return StringManager::get_string_by_id(*this).data();
 }
 
 auto
-loki::StringManager::get_string_by_id(loki::StringID id) -> const std::string&
+loki::StringManager::get_string_by_id(loki::StringID id) -> std::string_view
 {
-  std::shared_lock<std::shared_mutex> lock(mutex);
-  auto it = id_to_string.find(id);
-  if (it != id_to_string.end()) {
-    return it->second;
+  if (const Entry* entry = get_shard(id.id).find(id.id)) {
+    return entry->get_view();
   }
 
   return invalid_string;
 }
 
 auto
-loki::StringManager::get_id_by_string(const std::string& string) -> loki::StringID
+loki::StringManager::get_id_by_string(std::string_view string) -> loki::StringID
 {
-  {
-    std::shared_lock<std::shared_mutex> lock(mutex);
-    auto it = string_to_id.find(string);
-    if (it != string_to_id.end()) {
-      return it->second;
-    }
+  StringID id = StringID::from_id(hash_string(string));
+  // 0 is the default (invalid) ID, a string hashing to it would be indistinguishable from "no string"
+  ASSERT(id.id != 0, "StringID hash collision with the invalid ID", string);
+
+  get_shard(id.id).intern(id.id, string);
+  return id;
+}
+
+auto
+loki::StringManager::get_string_count() -> std::size_t
+{
+  std::size_t count = 0;
+  for (auto& shard : get_shards()) {
+    count += shard.get_count();
   }
 
-  StringID id = StringID{};
+  return count;
+}
 
-  {
-    std::unique_lock<std::shared_mutex> lock(mutex);
-    assert(string_counter < std::numeric_limits<std::size_t>::max());
-    id.id = string_counter++;
-    string_to_id.insert({ string, id });
-    id_to_string.insert({ id, string });
+auto
+loki::StringManager::get_memory_usage() -> std::size_t
+{
+  std::size_t bytes = 0;
+  for (auto& shard : get_shards()) {
+    bytes += shard.get_memory_usage();
   }
 
-  return id;
+  return bytes;
 }
@@ -2,49 +2,91 @@
 
 #include <spdlog/spdlog.h>
 
-#include <format>
-#include <shared_mutex>
-#include <string>
-#include <thread>
-#include <unordered_map>
+#include <cstddef>
+#include <string_view>
+
+#include "engine/utils/string_hash.h"
+#include "engine/utils/types.h"
 
 namespace loki {
 
   class StringManager;
 
+  // The ID is the stable 64-bit hash of the string, so it's the same in every run and can be stored
+  // in on-disk caches. Only the reverse lookup (ID to string) needs the string to be interned.
   class StringID
   {
     friend struct std::hash<StringID>;
     friend class StringManager;
 
   public:
-    explicit StringID();
-    explicit StringID(const std::string& string);
+    constexpr explicit StringID()
+      : id{ 0 }
+    {
+    }
+
+    // Interns the string, so it can be turned back into text and is checked for hash collisions
+    explicit StringID(std::string_view string);
+
+    // No interning at all, see the _sid literal
+    static constexpr auto from_literal(std::string_view string) -> StringID
+    {
+      return from_id(hash_string(string));
+    }
+
+    static constexpr auto from_id(u64 id) -> StringID
+    {
+      StringID result;
+      result.id = id;
+      return result;
+    }
+
+    constexpr auto get_id() const -> u64
+    {
+      return id;
+    }
+
+    // Both point into the string arena, so they stay valid until the process exits.
+    // An ID whose string was never interned in this run gives the empty string.
+    auto to_string_view() const -> std::string_view;
+    auto c_str() const -> const char*;
 
-    auto to_string() const -> const std::string&;
-    bool operator==(const StringID& other) const;
+    constexpr bool operator==(const StringID& other) const
+    {
+      return id == other.id;
+    }
 
   private:
-    std::size_t id;
+    u64 id;
   };
 
+  // Interned strings live once in an append-only arena, split into shards by hash.
+  // Lookups by ID and by string never take a lock, only inserting a new string locks its shard.
   class StringManager
   {
     friend class StringID;
 
   public:
-    static std::string invalid_string;
+    static constexpr std::string_view invalid_string{ "" };
 
-  private:
-    static auto get_string_by_id(StringID id) -> const std::string&;
-    static auto get_id_by_string(const std::string& string) -> StringID;
+    static auto get_string_count() -> std::size_t;
+    static auto get_memory_usage() -> std::size_t;
 
-    static std::shared_mutex mutex;
-    static std::size_t string_counter;
-    static std::unordered_map<StringID, std::string> id_to_string;
-    static std::unordered_map<std::string, StringID> string_to_id;
+  private:
+    static auto get_string_by_id(StringID id) -> std::string_view;
+    static auto get_id_by_string(std::string_view string) -> StringID;
   };
 
+  namespace literals {
+
+    // "model"_sid is hashed by the compiler, it costs nothing at runtime
+    consteval auto operator""_sid(const char* string, std::size_t length) -> StringID
+    {
+      return StringID::from_literal({ string, length });
+    }
+
+  } // namespace literals
+
 } // namespace loki
 
 template<>
@@ -52,6 +94,7 @@ struct std::hash<loki::StringID>
 {
   std::size_t operator()(const loki::StringID& string) const
   {
-    return hash<std::size_t>{}(string.id);
+    // Already a well mixed hash
+    return static_cast<std::size_t>(string.id);
   }
 };
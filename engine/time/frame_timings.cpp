@@ -0,0 +1,68 @@
+#include "frame_timings.h"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <numeric>
+
+#include "spdlog/spdlog.h"
+
+void
+loki::FrameTimingLog::reserve(size_t frame_count)
+{
+  frames.reserve(frame_count);
+}
+
+void
+loki::FrameTimingLog::record(const loki::FrameTiming& timing)
+{
+  frames.push_back(timing);
+}
+
+auto
+loki::FrameTimingLog::write(const std::filesystem::path& path) const -> bool
+{
+  if (path.has_parent_path()) {
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+  }
+
+  std::ofstream file{ path };
+  if (!file) {
+    spdlog::error("Failed to open {} for the frame timings", path.string());
+    return false;
+  }
+
+  file << "frame,updates,update_ms,render_ms,gui_ms,finish_ms,render_thread_ms,frame_ms,allocations\n";
+  for (size_t i = 0; i < frames.size(); ++i) {
+    const FrameTiming& timing = frames[i];
+    file << std::format("{},{},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{}\n", i, timing.updates, timing.update_ms, timing.render_ms, timing.gui_ms, timing.finish_ms,
+        timing.render_thread_ms, timing.frame_ms, timing.allocations);
+  }
+
+  spdlog::info("Frame timings of {} frames written to {}", frames.size(), path.string());
+  return static_cast<bool>(file);
+}
+
+void
+loki::FrameTimingLog::log_summary() const
+{
+  if (frames.empty()) {
+    return;
+  }
+
+  std::vector<double> frame_ms(frames.size());
+  std::transform(frames.begin(), frames.end(), frame_ms.begin(), [](const FrameTiming& timing) {
+    return timing.frame_ms;
+  });
+
+  std::sort(frame_ms.begin(), frame_ms.end());
+
+  auto percentile = [&frame_ms](double p) {
+    return frame_ms[std::min(frame_ms.size() - 1, static_cast<size_t>(p * static_cast<double>(frame_ms.size())))];
+  };
+
+  double mean = std::accumulate(frame_ms.begin(), frame_ms.end(), 0.0) / static_cast<double>(frame_ms.size());
+  spdlog::info("Frame time over {} frames: mean {:.3f} ms, p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms", frame_ms.size(), mean, percentile(0.5),
+      percentile(0.95), percentile(0.99), frame_ms.back());
+}
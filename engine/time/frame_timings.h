@@ -0,0 +1,48 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "engine/utils/types.h"
+
+namespace loki {
+
+  // CPU side of one frame in milliseconds. In a headless run the GL work is waited for at the end of every
+  // frame, with llvmpipe that's where the rasterization cost shows up.
+  struct FrameTiming
+  {
+    // Fixed simulation steps taken this frame, update_ms covers all of them
+    u32 updates{ 0 };
+    double update_ms{ 0.0 };
+    double render_ms{ 0.0 };
+    double gui_ms{ 0.0 };
+    // Waiting on GL, or on the render thread when there is one
+    double finish_ms{ 0.0 };
+    // What the render thread spent on the previous frame, 0 without one
+    double render_thread_ms{ 0.0 };
+    double frame_ms{ 0.0 };
+    // Global heap allocations made by the main thread, see engine/memory/counting_new_delete.h
+    u32 allocations{ 0 };
+  };
+
+  class FrameTimingLog
+  {
+  public:
+    void reserve(size_t frame_count);
+    void record(const FrameTiming& timing);
+
+    // One CSV row per frame, ready for a spreadsheet or a plotting script
+    auto write(const std::filesystem::path& path) const -> bool;
+    // Mean and percentiles of the whole frame time
+    void log_summary() const;
+
+    auto get_frames() const -> const std::vector<FrameTiming>&
+    {
+      return frames;
+    }
+
+  private:
+    std::vector<FrameTiming> frames;
+  };
+
+} // namespace loki
@@ -0,0 +1,241 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+#include "spdlog/spdlog.h"
+
+namespace {
+
+  constexpr size_t RING_MASK = loki::Profiler::RING_SIZE - 1;
+  constexpr size_t MAX_FRAMES = 0x200;
+
+  static_assert((loki::Profiler::RING_SIZE & RING_MASK) == 0, "The ring size has to be a power of two");
+
+  // Fields are atomics so a reader copying a slot the owner is rewriting is a stale value, not a data race.
+  // Relaxed stores of aligned words are plain moves, the owner pays nothing for it.
+  struct Slot
+  {
+    std::atomic<const char*> name{ nullptr };
+    std::atomic<loki::u64> start_ns{ 0 };
+    std::atomic<loki::u64> end_ns{ 0 };
+    std::atomic<loki::u32> depth{ 0 };
+  };
+
+  struct ThreadRing
+  {
+    explicit ThreadRing(loki::u32 id)
+      : id{ id }
+      , slots{ std::make_unique<Slot[]>(loki::Profiler::RING_SIZE) }
+    {
+    }
+
+    void push(const char* name, loki::u64 start_ns, loki::u64 end_ns, loki::u32 depth)
+    {
+      loki::u64 index = head.load(std::memory_order_relaxed);
+      Slot& slot = slots[index & RING_MASK];
+      slot.name.store(name, std::memory_order_relaxed);
+      slot.start_ns.store(start_ns, std::memory_order_relaxed);
+      slot.end_ns.store(end_ns, std::memory_order_relaxed);
+      slot.depth.store(depth, std::memory_order_relaxed);
+      head.store(index + 1, std::memory_order_release);
+    }
+
+    // Copies the events that ended at or after from_ns, minus whatever the owner overwrote meanwhile.
+    // Events are pushed in the order they end, so the copy walks back from the newest one and stops early.
+    auto snapshot(loki::u64 from_ns) const -> std::vector<loki::ProfileEvent>
+    {
+      loki::u64 end = head.load(std::memory_order_acquire);
+      loki::u64 begin = end > loki::Profiler::RING_SIZE ? end - loki::Profiler::RING_SIZE : 0;
+
+      std::vector<loki::ProfileEvent> events;
+      loki::u64 first = end;
+      while (first > begin) {
+        const Slot& slot = slots[(first - 1) & RING_MASK];
+        loki::ProfileEvent event{ slot.name.load(std::memory_order_relaxed), slot.start_ns.load(std::memory_order_relaxed), slot.end_ns.load(std::memory_order_relaxed),
+          slot.depth.load(std::memory_order_relaxed) };
+
+        if (event.end_ns < from_ns) {
+          break;
+        }
+
+        events.push_back(event);
+        --first;
+      }
+
+      // Slots below the new write index minus the ring size were reused while we were reading them, and the
+      // one at the write index itself may be half rewritten (push() bumps head after writing the slot)
+      std::atomic_thread_fence(std::memory_order_acquire);
+      loki::u64 new_end = head.load(std::memory_order_relaxed);
+      if (new_end >= loki::Profiler::RING_SIZE && new_end + 1 - loki::Profiler::RING_SIZE > first) {
+        size_t overwritten = std::min<size_t>(new_end + 1 - loki::Profiler::RING_SIZE - first, events.size());
+        events.resize(events.size() - overwritten);
+      }
+
+      std::reverse(events.begin(), events.end());
+      return events;
+    }
+
+    loki::u32 id;
+    std::string name;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<loki::u64> head{ 0 };
+  };
+
+  const auto epoch = std::chrono::steady_clock::now();
+
+  // Rings outlive their threads, a trace saved later still shows what a finished thread did
+  std::mutex rings_mutex;
+  std::vector<std::unique_ptr<ThreadRing>> rings;
+
+  std::mutex frames_mutex;
+  std::deque<loki::u64> frame_starts;
+
+  thread_local ThreadRing* thread_ring{ nullptr };
+  thread_local loki::u32 thread_depth{ 0 };
+
+  auto get_thread_ring() -> ThreadRing&
+  {
+    if (!thread_ring) {
+      std::lock_guard lock(rings_mutex);
+      thread_ring = rings.emplace_back(std::make_unique<ThreadRing>(static_cast<loki::u32>(rings.size()))).get();
+    }
+
+    return *thread_ring;
+  }
+
+  auto escape_json(std::string_view string) -> std::string
+  {
+    std::string escaped;
+    escaped.reserve(string.size());
+    for (char c : string) {
+      if (c == '"' || c == '\\') {
+        escaped += '\\';
+      }
+
+      escaped += c;
+    }
+
+    return escaped;
+  }
+
+} // namespace
+
+void
+loki::Profiler::set_enabled(bool _enabled)
+{
+  enabled.store(_enabled, std::memory_order_relaxed);
+}
+
+void
+loki::Profiler::set_thread_name(std::string_view name)
+{
+  ThreadRing& ring = get_thread_ring();
+
+  std::lock_guard lock(rings_mutex);
+  ring.name = name;
+}
+
+auto
+loki::Profiler::now() -> loki::u64
+{
+  return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+void
+loki::Profiler::mark_frame()
+{
+  u64 timestamp = now();
+
+  std::lock_guard lock(frames_mutex);
+  frame_starts.push_back(timestamp);
+  if (frame_starts.size() > MAX_FRAMES) {
+    frame_starts.pop_front();
+  }
+}
+
+auto
+loki::Profiler::get_last_frame() -> loki::ProfileFrame
+{
+  std::lock_guard lock(frames_mutex);
+  if (frame_starts.size() < 2) {
+    return {};
+  }
+
+  return { frame_starts[frame_starts.size() - 2], frame_starts.back() };
+}
+
+auto
+loki::Profiler::collect(loki::u64 from_ns, loki::u64 to_ns) -> std::vector<loki::ProfileThread>
+{
+  std::vector<ProfileThread> threads;
+
+  std::lock_guard lock(rings_mutex);
+  for (const auto& ring : rings) {
+    ProfileThread& thread = threads.emplace_back();
+    thread.id = ring->id;
+    thread.name = ring->name.empty() ? std::format("Thread {}", ring->id) : ring->name;
+
+    for (const auto& event : ring->snapshot(from_ns)) {
+      if (event.start_ns <= to_ns) {
+        thread.events.push_back(event);
+      }
+    }
+  }
+
+  return threads;
+}
+
+auto
+loki::Profiler::write_chrome_trace(const std::filesystem::path& path) -> bool
+{
+  auto threads = collect(0, ~u64{ 0 });
+
+  std::ofstream file{ path };
+  if (!file) {
+    spdlog::error("Failed to open {} for the trace", path.string());
+    return false;
+  }
+
+  // Complete ("X") events in microseconds, plus a metadata event naming each thread
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+  size_t event_count = 0;
+  const char* separator = "";
+  for (const auto& thread : threads) {
+    file << std::format("{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}", separator, thread.id, escape_json(thread.name));
+    separator = ",\n";
+
+    for (const auto& event : thread.events) {
+      file << std::format(",\n{{\"name\":\"{}\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}", escape_json(event.name), thread.id,
+          static_cast<double>(event.start_ns) / 1'000.0, static_cast<double>(event.end_ns - event.start_ns) / 1'000.0);
+    }
+
+    event_count += thread.events.size();
+  }
+
+  file << "\n]}\n";
+
+  spdlog::info("Chrome trace with {} events written to {}", event_count, path.string());
+  return static_cast<bool>(file);
+}
+
+auto
+loki::Profiler::begin_zone() -> loki::u64
+{
+  ++thread_depth;
+  // 0 means "not recording" to ProfileZone
+  return std::max<u64>(now(), 1);
+}
+
+void
+loki::Profiler::end_zone(const char* name, loki::u64 start_ns)
+{
+  --thread_depth;
+  get_thread_ring().push(name, start_ns, now(), thread_depth);
+}
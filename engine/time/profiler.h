@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "engine/utils/types.h"
+
+// 0 compiles every zone out, the runtime switch (Profiler::set_enabled) costs a relaxed load per zone
+#ifndef LOKI_PROFILER_ENABLED
+#define LOKI_PROFILER_ENABLED 1
+#endif
+
+namespace loki {
+
+  struct ProfileEvent
+  {
+    // Zone names are string literals, only the pointer is recorded
+    const char* name{ nullptr };
+    u64 start_ns{ 0 };
+    u64 end_ns{ 0 };
+    u32 depth{ 0 };
+  };
+
+  struct ProfileThread
+  {
+    u32 id{ 0 };
+    std::string name;
+    // Ordered by end time, a parent zone comes after its children
+    std::vector<ProfileEvent> events;
+  };
+
+  struct ProfileFrame
+  {
+    u64 start_ns{ 0 };
+    u64 end_ns{ 0 };
+  };
+
+  // Every thread records finished zones into a ring of its own, without locks: the owning thread is the
+  // only writer and readers validate what they copied against the write index afterwards. Old events are
+  // overwritten, a ring keeps roughly the last RING_SIZE zones of its thread.
+  struct Profiler
+  {
+    static constexpr size_t RING_SIZE = 0x10000;
+
+    static void set_enabled(bool enabled);
+    static auto is_enabled() -> bool
+    {
+      return enabled.load(std::memory_order_relaxed);
+    }
+
+    // Shown in the flame view and the trace, threads without a name are listed by their ID
+    static void set_thread_name(std::string_view name);
+
+    // Nanoseconds since the profiler started, steady_clock based
+    static auto now() -> u64;
+
+    // Start of a new frame on the main thread, the flame view shows the last complete one
+    static void mark_frame();
+    static auto get_last_frame() -> ProfileFrame;
+
+    // Events of every thread overlapping [from_ns, to_ns]
+    static auto collect(u64 from_ns, u64 to_ns) -> std::vector<ProfileThread>;
+    // Everything still in the rings as a Chrome trace (chrome://tracing, Perfetto)
+    static auto write_chrome_trace(const std::filesystem::path& path) -> bool;
+
+    static auto begin_zone() -> u64;
+    static void end_zone(const char* name, u64 start_ns);
+
+  private:
+    static inline std::atomic<bool> enabled{ true };
+  };
+
+  class ProfileZone
+  {
+  public:
+    explicit ProfileZone(const char* name)
+      : name{ name }
+      , start_ns{ Profiler::is_enabled() ? Profiler::begin_zone() : 0 }
+    {
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+    ~ProfileZone()
+    {
+      if (start_ns) {
+        Profiler::end_zone(name, start_ns);
+      }
+    }
+
+  private:
+    const char* name;
+    u64 start_ns;
+  };
+
+} // namespace loki
+
+#define LOKI_PROFILE_CONCAT_IMPL(a, b) a##b
+#define LOKI_PROFILE_CONCAT(a, b) LOKI_PROFILE_CONCAT_IMPL(a, b)
+
+#if LOKI_PROFILER_ENABLED
+#define LOKI_PROFILE_ZONE(name) ::loki::ProfileZone LOKI_PROFILE_CONCAT(profile_zone_, __LINE__){ name }
+#define LOKI_PROFILE_FRAME() ::loki::Profiler::mark_frame()
+#define LOKI_PROFILE_THREAD(name) ::loki::Profiler::set_thread_name(name)
+#else
+#define LOKI_PROFILE_ZONE(name)
+#define LOKI_PROFILE_FRAME()
+#define LOKI_PROFILE_THREAD(name)
+#endif
@@ -0,0 +1,121 @@
+#include "profiler_view.h"
+
+#include <algorithm>
+
+#include "engine/utils/string_hash.h"
+#include "imgui.h"
+
+namespace {
+
+  constexpr float ROW_HEIGHT = 18.f;
+  // Narrower zones are drawn but not labelled
+  constexpr float MIN_LABEL_WIDTH = 24.f;
+
+  // Same name, same color, from one frame to the next
+  auto get_zone_color(const char* name) -> ImU32
+  {
+    loki::u64 hash = loki::hash_string(name);
+    return IM_COL32(96 + (hash & 0x7F), 96 + ((hash >> 8) & 0x7F), 96 + ((hash >> 16) & 0x7F), 255);
+  }
+
+  auto to_ms(loki::u64 ns) -> float
+  {
+    return static_cast<float>(static_cast<double>(ns) / 1'000'000.0);
+  }
+
+} // namespace
+
+void
+loki::ProfilerView::draw(const std::filesystem::path& trace_path, const std::vector<loki::GpuTiming>& gpu_timings)
+{
+  if (ImGui::Begin("Profiler")) {
+    bool enabled = Profiler::is_enabled();
+    if (ImGui::Checkbox("Enabled", &enabled)) {
+      Profiler::set_enabled(enabled);
+    }
+
+    ImGui::SameLine();
+    ImGui::Checkbox("Pause", &paused);
+
+    ImGui::SameLine();
+    if (ImGui::Button("Save trace")) {
+      Profiler::write_chrome_trace(trace_path);
+    }
+
+    if (!paused) {
+      ProfileFrame last_frame = Profiler::get_last_frame();
+      if (last_frame.end_ns != frame.end_ns) {
+        frame = last_frame;
+        threads = Profiler::collect(frame.start_ns, frame.end_ns);
+
+        gpu.events.clear();
+        for (const auto& timing : gpu_timings) {
+          u64 start_ns = frame.start_ns + timing.start_ns;
+          gpu.events.push_back({ timing.name, start_ns, start_ns + timing.duration_ns, timing.depth });
+        }
+
+        frame_history[history_offset] = to_ms(frame.end_ns - frame.start_ns);
+        history_offset = (history_offset + 1) % frame_history.size();
+      }
+    }
+
+    // The first GPU zone is the whole frame
+    float gpu_ms = gpu.events.empty() ? 0.f : to_ms(gpu.events.front().end_ns - gpu.events.front().start_ns);
+    ImGui::Text("Frame: %.3f ms, GPU: %.3f ms", to_ms(frame.end_ns - frame.start_ns), gpu_ms);
+    ImGui::PlotLines("##frame_history", frame_history.data(), static_cast<int>(frame_history.size()), static_cast<int>(history_offset), nullptr, 0.f, 50.f,
+        ImVec2{ 0.f, 48.f });
+
+    for (const auto& thread : threads) {
+      if (!thread.events.empty() && ImGui::CollapsingHeader(thread.name.c_str(), ImGuiTreeNodeFlags_DefaultOpen)) {
+        draw_thread(thread);
+      }
+    }
+
+    if (gpu.events.empty()) {
+      ImGui::TextDisabled("No GPU timings, timer queries aren't supported");
+    } else if (ImGui::CollapsingHeader("GPU", ImGuiTreeNodeFlags_DefaultOpen)) {
+      draw_thread(gpu);
+    }
+  }
+
+  ImGui::End();
+}
+
+void
+loki::ProfilerView::draw_thread(const loki::ProfileThread& thread)
+{
+  u32 max_depth = 0;
+  for (const auto& event : thread.events) {
+    max_depth = std::max(max_depth, event.depth);
+  }
+
+  ImDrawList* draw_list = ImGui::GetWindowDrawList();
+  ImVec2 origin = ImGui::GetCursorScreenPos();
+  float width = std::max(ImGui::GetContentRegionAvail().x, 1.f);
+  float scale = width / static_cast<float>(std::max<u64>(frame.end_ns - frame.start_ns, 1));
+
+  for (const auto& event : thread.events) {
+    // Zones crossing a frame boundary are cut at it
+    u64 start_ns = std::max(event.start_ns, frame.start_ns);
+    u64 end_ns = std::min(event.end_ns, frame.end_ns);
+    if (end_ns < start_ns) {
+      continue;
+    }
+
+    ImVec2 min{ origin.x + static_cast<float>(start_ns - frame.start_ns) * scale, origin.y + static_cast<float>(event.depth) * ROW_HEIGHT };
+    ImVec2 max{ std::max(origin.x + static_cast<float>(end_ns - frame.start_ns) * scale, min.x + 1.f), min.y + ROW_HEIGHT - 1.f };
+
+    draw_list->AddRectFilled(min, max, get_zone_color(event.name));
+    if (max.x - min.x >= MIN_LABEL_WIDTH) {
+      draw_list->PushClipRect(min, max, true);
+      draw_list->AddText(ImVec2{ min.x + 2.f, min.y + 1.f }, IM_COL32(0, 0, 0, 255), event.name);
+      draw_list->PopClipRect();
+    }
+
+    if (ImGui::IsMouseHoveringRect(min, max)) {
+      ImGui::SetTooltip("%s: %.3f ms", event.name, to_ms(event.end_ns - event.start_ns));
+    }
+  }
+
+  ImGui::Dummy(ImVec2{ width, static_cast<float>(max_depth + 1) * ROW_HEIGHT });
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <vector>
+
+#include "engine/render/gpu_timer.h"
+#include "engine/time/profiler.h"
+
+namespace loki {
+
+  // ImGui "Profiler" window: frame time history and a flame graph of the last complete frame, one lane per
+  // thread plus one for the GPU. The GPU lane is a few frames older and starts where the CPU frame does.
+  class ProfilerView
+  {
+  public:
+    void draw(const std::filesystem::path& trace_path, const std::vector<GpuTiming>& gpu_timings);
+
+  private:
+    void draw_thread(const ProfileThread& thread);
+
+  private:
+    static constexpr size_t HISTORY_SIZE = 0x100;
+
+  private:
+    bool paused{ false };
+    ProfileFrame frame;
+    std::vector<ProfileThread> threads;
+    ProfileThread gpu;
+    std::array<float, HISTORY_SIZE> frame_history{};
+    size_t history_offset{ 0 };
+  };
+
+} // namespace loki
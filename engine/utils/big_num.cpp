@@ -1,5 +1,7 @@
 #include "big_num.h"
 
+#include "engine/crypto/crypto_random.h"
+
 loki::BigNum::BigNum()
   : bn(BN_new())
 {
@@ -114,7 +116,24 @@ loki::BigNum::get_bytes(loki::u8* buf, size_t buf_size) const
 void
 loki::BigNum::set_rand(loki::i32 num_bits)
 {
-  BN_rand(bn, num_bits, 0, 1);
+  // Same contract as BN_rand(bn, num_bits, 0, 1), but the bytes come from our generator,
+  // so the value follows the deterministic mode of crypto::get_random_bytes
+  if (num_bits <= 0) {
+    BN_zero(bn);
+    return;
+  }
+
+  std::vector<u8> bytes((num_bits + 7) / 8);
+  crypto::get_random_bytes(bytes);
+
+  // Big-endian: drop the excess high bits, force the top one (top = 0) and make it odd (bottom = 1)
+  i32 top_bit = (num_bits - 1) % 8;
+  bytes.front() &= static_cast<u8>((1 << (top_bit + 1)) - 1);
+  bytes.front() |= static_cast<u8>(1 << top_bit);
+  bytes.back() |= 1;
+
+  BN_bin2bn(bytes.data(), (int)bytes.size(), bn);
+  OPENSSL_cleanse(bytes.data(), bytes.size());
 }
 
 loki::BigNum&
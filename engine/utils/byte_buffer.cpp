@@ -5,6 +5,12 @@ loki::ByteBuffer::ByteBuffer()
   buffer.reserve(DEFAULT_SIZE);
 }
 
+loki::ByteBuffer::ByteBuffer(const loki::ByteBuffer& other)
+  : buffer{ other.buffer, get_memory_resource(MemoryDomain::NETWORK) }
+  , r_pos{ other.r_pos }
+{
+}
+
 void
 loki::ByteBuffer::append(const std::vector<loki::u8>& value)
 {
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <memory_resource>
 #include <string>
 #include <vector>
 
+#include "engine/memory/memory_domain.h"
 #include "engine/utils/types.h"
 #include "libassert/assert.hpp"
 #include "pfr.hpp"
@@ -18,6 +20,11 @@ namespace loki {
 
   public:
     explicit ByteBuffer();
+    // The copy stays in the NETWORK domain, a copied pmr vector would go to the default resource
+    ByteBuffer(const ByteBuffer& other);
+    ByteBuffer(ByteBuffer&& other) noexcept = default;
+    ByteBuffer& operator=(const ByteBuffer& other) = default;
+    ByteBuffer& operator=(ByteBuffer&& other) noexcept = default;
 
   public:
     void reset();
@@ -89,7 +96,7 @@ namespace loki {
     void load_buffer(T& value);
 
   protected:
-    std::vector<loki::u8> buffer;
+    std::pmr::vector<loki::u8> buffer{ get_memory_resource(MemoryDomain::NETWORK) };
     std::size_t r_pos = 0;
   };
 
@@ -0,0 +1,116 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "spdlog/spdlog.h"
+
+loki::MappedFile::MappedFile(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+  file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    file = nullptr;
+    spdlog::error("Failed to open {} for mapping", path.string());
+    return;
+  }
+
+  LARGE_INTEGER file_size{};
+  GetFileSizeEx(file, &file_size);
+  mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    spdlog::error("Failed to map {}", path.string());
+    close();
+    return;
+  }
+
+  data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  size = data ? static_cast<size_t>(file_size.QuadPart) : 0;
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    spdlog::error("Failed to open {} for mapping", path.string());
+    return;
+  }
+
+  struct stat status{};
+  if (fstat(fd, &status) == 0 && status.st_size > 0) {
+    void* memory = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (memory != MAP_FAILED) {
+      data = static_cast<const std::byte*>(memory);
+      size = static_cast<size_t>(status.st_size);
+    }
+  }
+
+  // The mapping keeps the file referenced on its own
+  ::close(fd);
+#endif
+
+  if (!data) {
+    spdlog::error("Failed to map {}", path.string());
+  }
+}
+
+loki::MappedFile::MappedFile(loki::MappedFile&& other) noexcept
+  : data{ std::exchange(other.data, nullptr) }
+  , size{ std::exchange(other.size, 0) }
+#ifdef _WIN32
+  , file{ std::exchange(other.file, nullptr) }
+  , mapping{ std::exchange(other.mapping, nullptr) }
+#endif
+{
+}
+
+loki::MappedFile&
+loki::MappedFile::operator=(loki::MappedFile&& other) noexcept
+{
+  if (this != &other) {
+    close();
+    data = std::exchange(other.data, nullptr);
+    size = std::exchange(other.size, 0);
+#ifdef _WIN32
+    file = std::exchange(other.file, nullptr);
+    mapping = std::exchange(other.mapping, nullptr);
+#endif
+  }
+
+  return *this;
+}
+
+loki::MappedFile::~MappedFile()
+{
+  close();
+}
+
+void
+loki::MappedFile::close()
+{
+#ifdef _WIN32
+  if (data) {
+    UnmapViewOfFile(data);
+  }
+  if (mapping) {
+    CloseHandle(mapping);
+  }
+  if (file) {
+    CloseHandle(file);
+  }
+  file = nullptr;
+  mapping = nullptr;
+#else
+  if (data) {
+    munmap(const_cast<std::byte*>(data), size);
+  }
+#endif
+
+  data = nullptr;
+  size = 0;
+}
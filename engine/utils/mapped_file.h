@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace loki {
+
+  // Read-only memory map of a whole file, pages are only read from disk once they are touched
+  class MappedFile
+  {
+  public:
+    explicit MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path& path);
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+  public:
+    auto is_valid() const -> bool
+    {
+      return data != nullptr;
+    }
+
+    auto get_span() const -> std::span<const std::byte>
+    {
+      return { data, size };
+    }
+
+  private:
+    void close();
+
+  private:
+    const std::byte* data{ nullptr };
+    size_t size{ 0 };
+#ifdef _WIN32
+    void* file{ nullptr };
+    void* mapping{ nullptr };
+#endif
+  };
+
+} // namespace loki
@@ -0,0 +1,91 @@
+#include "perfect_hash.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "engine/time/profiler.h"
+
+namespace {
+
+  // splitmix64's finalizer
+  auto mix(loki::u64 value) -> loki::u64
+  {
+    value = (value ^ (value >> 30)) * 0xBF58'476D'1CE4'E5B9;
+    value = (value ^ (value >> 27)) * 0x94D0'49BB'1331'11EB;
+    return value ^ (value >> 31);
+  }
+
+} // namespace
+
+auto
+loki::PerfectHash::get_bucket(loki::u64 key, loki::u32 bucket_count) -> loki::u32
+{
+  return static_cast<u32>(mix(key) % bucket_count);
+}
+
+auto
+loki::PerfectHash::get_slot(loki::u64 key, loki::u32 seed, loki::u32 slot_count) -> loki::u32
+{
+  return static_cast<u32>(mix(key ^ (seed * 0x9E37'79B9'7F4A'7C15)) % slot_count);
+}
+
+// The biggest buckets first, each gets the first seed that puts all of its keys in free slots
+auto
+loki::PerfectHash::build(std::span<const loki::u64> keys) -> loki::PerfectHash
+{
+  LOKI_PROFILE_ZONE("Build perfect hash");
+
+  PerfectHash result;
+  auto key_count = static_cast<u32>(keys.size());
+  auto bucket_count = std::max(1u, (key_count + BUCKET_SIZE - 1) / BUCKET_SIZE);
+  result.slot_count = std::max(1u, static_cast<u32>(key_count / LOAD_FACTOR) + 1);
+  result.seeds.resize(bucket_count);
+  result.key_slots.resize(key_count);
+
+  std::vector<std::vector<u32>> buckets(bucket_count);
+  for (u32 i = 0; i < key_count; ++i) {
+    buckets[get_bucket(keys[i], bucket_count)].push_back(i);
+  }
+
+  std::vector<u32> order(bucket_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&buckets](u32 a, u32 b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  std::vector<bool> taken(result.slot_count);
+  std::vector<u32> slots;
+  for (u32 bucket : order) {
+    if (buckets[bucket].empty()) {
+      break;
+    }
+
+    bool placed = false;
+    for (u32 seed = 1; seed < MAX_SEED && !placed; ++seed) {
+      slots.clear();
+      placed = true;
+      for (u32 key : buckets[bucket]) {
+        u32 slot = get_slot(keys[key], seed, result.slot_count);
+        if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+          placed = false;
+          break;
+        }
+        slots.push_back(slot);
+      }
+
+      if (placed) {
+        result.seeds[bucket] = seed;
+        for (size_t i = 0; i < slots.size(); ++i) {
+          taken[slots[i]] = true;
+          result.key_slots[buckets[bucket][i]] = slots[i];
+        }
+      }
+    }
+
+    if (!placed) {
+      return {};
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "types.h"
+
+namespace loki {
+
+  // Hash and displace over a fixed set of distinct 64 bit keys: a key goes to a bucket, and the bucket's
+  // seed puts it in a slot no other key has. A lookup is the seed read, then the one slot the key can be
+  // in, so whoever stores the slots has to keep the key next to the value to tell a miss apart. About
+  // a byte of seeds per key, and a tenth of the slots stay empty.
+  class PerfectHash
+  {
+  public:
+    // Keys per bucket on average, and slots per key, more of either makes seeds harder to find
+    static constexpr u32 BUCKET_SIZE = 4;
+    static constexpr double LOAD_FACTOR = 0.9;
+    static constexpr u32 MAX_SEED = 0x100'0000;
+
+  public:
+    // Stable across builds and platforms, the asset pack keeps the seeds on disk
+    static auto get_bucket(u64 key, u32 bucket_count) -> u32;
+    static auto get_slot(u64 key, u32 seed, u32 slot_count) -> u32;
+
+    // Invalid when some bucket has no seed, which only happens when the keys aren't distinct
+    static auto build(std::span<const u64> keys) -> PerfectHash;
+
+  public:
+    auto is_valid() const -> bool
+    {
+      return !seeds.empty();
+    }
+
+    auto get_seeds() const -> std::span<const u32>
+    {
+      return seeds;
+    }
+
+    auto get_slot_count() const -> u32
+    {
+      return slot_count;
+    }
+
+    // Where the build put keys[index]
+    auto get_key_slot(size_t index) const -> u32
+    {
+      return key_slots[index];
+    }
+
+    // The one slot the key can be in, it is only there if it was one of the keys
+    auto find_slot(u64 key) const -> u32
+    {
+      u32 seed = seeds[get_bucket(key, static_cast<u32>(seeds.size()))];
+      return get_slot(key, seed, slot_count);
+    }
+
+  private:
+    std::vector<u32> seeds;
+    std::vector<u32> key_slots;
+    u32 slot_count{ 0 };
+  };
+
+} // namespace loki
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string_view>
+
+#include "types.h"
+
+namespace loki {
+
+  // FNV-1a over the bytes followed by the MurmurHash3 finalizer, so the low bits are usable for tables.
+  // It's constexpr and doesn't depend on the platform, compiler or run, so the values can go to disk.
+  constexpr auto hash_string(std::string_view string) -> u64
+  {
+    u64 hash = 0xCBF2'9CE4'8422'2325ull;
+    for (char ch : string) {
+      hash ^= static_cast<u8>(ch);
+      hash *= 0x100'0000'01B3ull;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51'AFD7'ED55'8CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CE'B9FE'1A85'EC53ull;
+    hash ^= hash >> 33;
+
+    return hash;
+  }
+
+} // namespace loki
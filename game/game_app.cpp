@@ -4,10 +4,12 @@
 
 #include "engine/utils/types.h"
 #include "glm/glm.hpp"
+#include "glm/gtc/constants.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "imgui.h"
 #include "spdlog/spdlog.h"
 
+#include <algorithm>
 #include <format>
 
 struct
@@ -16,6 +18,30 @@ struct
   float phi{ 5.182f }, theta{ 5.716f };
 } camera;
 
+namespace {
+
+  // Headless runs fly one full orbit over their frames, bobbing up and down twice on the way
+  void follow_camera_path(float progress)
+  {
+    constexpr float start_phi = 5.182f;
+    constexpr float start_theta = 5.716f;
+    constexpr float two_pi = glm::two_pi<float>();
+
+    camera.theta = start_theta + two_pi * progress;
+    camera.phi = start_phi + 0.25f * glm::sin(2.f * two_pi * progress);
+  }
+
+  auto get_camera_eye() -> glm::vec3
+  {
+    float x = camera.distance_to_origin * glm::sin(camera.phi) * glm::cos(camera.theta);
+    float y = camera.distance_to_origin * glm::cos(camera.phi);
+    float z = camera.distance_to_origin * glm::sin(camera.phi) * glm::sin(camera.theta);
+
+    return { x, y, z };
+  }
+
+} // namespace
+
 bool
 GameApp::on_init()
 {
@@ -24,6 +50,8 @@ GameApp::on_init()
   }
 
   sockpp::initialize();
+
+  eye = previous_eye = get_camera_eye();
   return true;
 }
 
@@ -39,22 +67,21 @@ GameApp::on_term()
 void
 GameApp::on_update()
 {
-  float x = camera.distance_to_origin * glm::sin(camera.phi) * glm::cos(camera.theta);
-  float y = camera.distance_to_origin * glm::cos(camera.phi);
-  float z = camera.distance_to_origin * glm::sin(camera.phi) * glm::sin(camera.theta);
-
-  view = glm::lookAt(glm::vec3(x, y, z), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
-
-  glm::ivec2 window_size;
-  glfwGetWindowSize(get_window(), &window_size.x, &window_size.y);
-  glViewport(0, 0, window_size.x, window_size.y);
+  if (is_headless()) {
+    follow_camera_path(static_cast<float>(get_update_index()) / static_cast<float>(std::max(get_headless_frames(), 1u)));
+  }
 
-  projection = glm::perspective(glm::radians(45.0f), (float)window_size.x / (float)window_size.y, 0.1f, 100.0f);
+  previous_eye = eye;
+  eye = get_camera_eye();
 }
 
 void
 GameApp::on_gui()
 {
+  draw_render_stats();
+  profiler_view.draw(get_trace_path(), get_gpu_timings());
+  memory_view.draw();
+
   if (ImGui::Begin("Auth")) {
     static char host[32] = "localhost";
     ImGui::InputText("Host", host, sizeof(host));
@@ -73,7 +100,7 @@ GameApp::on_gui()
     }
 
     if (auth_session) {
-      auto realms = auth_session->get_realms();
+      auto realms = auth_session->get_realms(get_frame_resource());
       int num_of_fields = pfr::detail::fields_count<loki::PacketAuthRealm>();
       if (ImGui::BeginTable("Realms", num_of_fields + 1, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
         // Table headers
@@ -91,9 +118,9 @@ GameApp::on_gui()
         for (const auto& realm : realms) {
           ImGui::TableNextRow();
 
-          pfr::for_each_field(realm, [](auto& field, auto field_index) {
+          pfr::for_each_field(realm, [this](auto& field, auto field_index) {
             ImGui::TableSetColumnIndex(field_index);
-            std::string string = std::format("{}", field);
+            auto string = loki::pmr_format(get_frame_resource(), "{}", field);
             ImGui::Text("%s", string.c_str());
           });
 
@@ -111,9 +138,52 @@ GameApp::on_gui()
   ImGui::End();
 }
 
+void
+GameApp::draw_render_stats()
+{
+  if (ImGui::Begin("Render")) {
+    const auto& stats = get_render_stats();
+    const auto& timing = get_last_frame_timing();
+    ImGui::Text("FPS: %.1f", get_fps());
+    ImGui::Text("Updates: %u (%.2f ms), render: %.2f ms, UI: %.2f ms", timing.updates, timing.update_ms, timing.render_ms, timing.gui_ms);
+    ImGui::Separator();
+    ImGui::Text("Commands: %u", stats.commands);
+    ImGui::Text("Draw calls: %u", stats.draw_calls);
+    ImGui::Text("Program binds: %u", stats.program_binds);
+    ImGui::Text("VAO binds: %u", stats.vertex_array_binds);
+    ImGui::Text("Texture binds: %u", stats.texture_binds);
+    ImGui::Text("Uniform block binds: %u", stats.uniform_block_binds);
+    ImGui::Text("Skipped (shader not ready or out of stream space): %u", stats.skipped);
+
+    const auto& stream = get_stream_buffer();
+    const auto& stream_stats = get_stream_stats();
+    ImGui::Separator();
+    ImGui::Text("Stream buffer (%s): %u / %u KiB", stream.is_persistent() ? "persistent" : "unsynchronized", stream_stats.used_bytes / 1'024, stream.get_frame_size() / 1'024);
+    ImGui::Text("Peak: %u KiB, overflows: %u, fence waits: %u", stream_stats.peak_bytes / 1'024, stream_stats.overflows, stream_stats.fence_waits);
+
+    const auto& arena_stats = get_frame_arena_stats();
+    ImGui::Separator();
+    ImGui::Text("Heap allocations: %u per frame", timing.allocations);
+    ImGui::Text("Frame arena: %u allocations, %llu KiB, peak %llu KiB, overflows: %u", arena_stats.allocations, static_cast<unsigned long long>(arena_stats.used_bytes / 1'024),
+        static_cast<unsigned long long>(arena_stats.peak_bytes / 1'024), arena_stats.overflows);
+  }
+
+  ImGui::End();
+}
+
 void
 GameApp::on_render()
 {
-  glClearColor(background.r, background.g, background.b, 1.0f);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  // The camera is simulated at a fixed rate, render it where it is between the last two steps
+  glm::vec3 render_eye = glm::mix(previous_eye, eye, get_interpolation_alpha());
+  view = glm::lookAt(render_eye, glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+
+  glm::ivec2 window_size = get_window_size();
+  projection = glm::perspective(glm::radians(45.0f), (float)window_size.x / (float)window_size.y, 0.1f, 100.0f);
+
+  // Only recorded here, the queue may well be drawn on the render thread
+  auto& render_queue = get_render_queue();
+  render_queue.set_viewport(window_size);
+  render_queue.set_clear_color(glm::vec4(background, 1.0f));
+  render_queue.set_camera(view, projection);
 }
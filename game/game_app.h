@@ -3,9 +3,11 @@
 #include <thread>
 
 #include "engine/engine_app.h"
+#include "engine/memory/memory_view.h"
 #include "engine/network/auth_session.h"
 #include "engine/network/world_session.h"
 #include "engine/render/shader.h"
+#include "engine/time/profiler_view.h"
 #include "glm/detail/type_mat4x4.hpp"
 #include "glm/vec3.hpp"
 
@@ -19,12 +21,20 @@ protected:
   void on_render() override;
   void on_gui() override;
 
+private:
+  void draw_render_stats();
+
 private:
   glm::vec3 background{ 0.144f, 0.186f, 0.311f };
   glm::mat4 model{ 1.f };
+  // Camera position after the last two simulation steps, rendering interpolates between them
+  glm::vec3 previous_eye{};
+  glm::vec3 eye{};
   glm::mat4 view{};
   glm::mat4 projection{};
   std::shared_ptr<loki::AuthSession> auth_session;
   std::shared_ptr<loki::WorldSession> world_session;
+  loki::ProfilerView profiler_view;
+  loki::MemoryView memory_view;
 };
 
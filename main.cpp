@@ -1,9 +1,10 @@
-#include <mimalloc-new-delete.h>
+#include "engine/memory/counting_new_delete.h"
 
 #include <CLI/CLI.hpp>
 #include <glm/glm.hpp>
 #include <spdlog/spdlog.h>
 
+#include "engine/crypto/crypto_random.h"
 #include "game/game_app.h"
 
 int
@@ -15,8 +16,39 @@ main(int argc, char* argv[])
   std::shared_ptr<loki::EngineSettings> settings = std::make_shared<loki::EngineSettings>();
 
   app.add_option("--root", settings->root_path);
+  app.add_option("--cache", settings->cache_path, "Directory for the shader binary cache");
+  app.add_option("--width", settings->window_width, "Window (or offscreen framebuffer) width");
+  app.add_option("--height", settings->window_height, "Window (or offscreen framebuffer) height");
+
+  app.add_option("--update-rate", settings->update_rate, "Fixed simulation steps per second");
+  app.add_option("--frame-cap", settings->frame_cap, "Frames per second with vsync off, 0 keeps vsync");
+  app.add_flag("--unlimited", settings->unlimited_frame_rate, "No vsync and no frame cap, for benchmarking");
+  app.add_flag("--render-thread", settings->render_thread, "Draw on a separate thread, one frame behind the simulation");
+
+  app.add_option("--jobs", settings->job_workers, "Job system threads, the main thread included, 0 for one per hardware thread");
+  app.add_flag("--pin-jobs", settings->pin_job_workers, "Pin every job system thread to a core of its own");
+  app.add_option("--pack", settings->asset_pack_path, "Asset pack written by loki_repack, read instead of the MPQs");
+  app.add_option("--mpq-cache", settings->mpq_cache_size, "Decompressed MPQ file cache in MiB, 0 turns it off");
+
+  app.add_flag("--headless", settings->headless, "Render offscreen (surfaceless EGL or a hidden window) along a scripted camera path, then exit");
+  app.add_option("--frames", settings->headless_frames, "Number of frames to render in a headless run");
+  app.add_option("--timings", settings->frame_timings_path, "CSV file for the per-frame timings of a headless run");
+
+  app.add_flag("!--no-profiler", settings->profiler, "Start with CPU zone recording off");
+  app.add_option("--trace", settings->trace_path, "Chrome trace file, written on exit and by the Profiler window")
+      ->each([&settings](const std::string&) {
+        settings->trace_on_exit = true;
+      });
+
+  std::optional<loki::u64> random_seed;
+  app.add_option("--random-seed", random_seed, "Deterministic crypto RNG for benchmarks and replays, never use it for real accounts");
   CLI11_PARSE(app, argc, argv)
 
+  if (random_seed) {
+    spdlog::warn("Crypto RNG is seeded with {}, all handshakes are predictable!", *random_seed);
+    loki::crypto::set_random_seed(*random_seed);
+  }
+
   spdlog::info("Root: {}", absolute(settings->root_path).string());
   return GameApp().launch(settings);
 }
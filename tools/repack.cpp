@@ -0,0 +1,49 @@
+#include <mimalloc-new-delete.h>
+
+#include <CLI/CLI.hpp>
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+
+#include "engine/datasource/mpq/mpq_chain.h"
+#include "engine/datasource/pack/asset_pack_writer.h"
+#include "engine/jobs/job_system.h"
+
+int
+main(int argc, char* argv[])
+{
+  CLI::App app{ "loki asset repacker: a client Data directory's MPQ chain into one flat pack" };
+  argv = app.ensure_utf8(argv);
+
+  std::filesystem::path data_path;
+  std::filesystem::path out_path;
+  loki::u32 job_workers = 0;
+  loki::AssetPackSettings settings;
+
+  app.add_option("--data", data_path, "Game client Data directory")->required();
+  app.add_option("--out", out_path, "Pack to write, mounted with loki --pack")->required();
+  app.add_option("--level", settings.compression_level, "LZ4HC compression level, 3 to 12");
+  app.add_option("--min-saving", settings.min_saving, "Smallest fraction compression has to save, files are stored raw otherwise");
+  app.add_option("--jobs", job_workers, "Job system threads, the main thread included, 0 for one per hardware thread");
+  CLI11_PARSE(app, argc, argv)
+
+  auto start = std::chrono::steady_clock::now();
+  loki::JobSystem::init({ job_workers });
+
+  bool written = false;
+  loki::AssetPackWriteStats stats;
+  {
+    // No index path: a repack reads every file once, the index is built for this run only
+    loki::MPQChain chain{ data_path };
+    written = loki::write_asset_pack(chain, out_path, settings, stats);
+  }
+
+  loki::JobSystem::term();
+  if (!written) {
+    return 1;
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  spdlog::info("{}: {} files, {} LZ4-compressed, {:.1f} MiB into {:.1f} MiB in {:.1f} s", out_path.string(), stats.file_count, stats.compressed_count, static_cast<double>(stats.raw_bytes) / 0x10'0000, static_cast<double>(stats.pack_bytes) / 0x10'0000, seconds);
+  return 0;
+}